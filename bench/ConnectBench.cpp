@@ -0,0 +1,216 @@
+/**
+ * \file   ConnectBench.cpp
+ * \author L. Nagy
+ *
+ * MIT License
+ *
+ * Copyright (c) [2016] Lesleis Nagy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+
+/**
+ * Benchmark of the canonical simplex functors (hash, equality, order) of the
+ * generic ConnectN<N> against the hand written Connect2/3/4 functors they
+ * replaced, which are reproduced here in namespace legacy.
+ *
+ * Usage: connect_bench [number of simplices]
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <unordered_set>
+#include <vector>
+
+#include "Data.h"
+#include "Utilities.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// The replaced functors.                                                    //
+///////////////////////////////////////////////////////////////////////////////
+
+namespace legacy {
+
+inline void compare_swap(uint & a, uint & b) {
+  if (a > b) {
+    uint tmp = a;
+    a = b;
+    b = tmp;
+  }
+}
+
+/// Sort n indices with the networks of the replaced functors.
+template <size_t N> void sort(uint (&v)[N]);
+template <> inline void sort<2>(uint (&v)[2]) {
+  compare_swap(v[0], v[1]);
+}
+template <> inline void sort<3>(uint (&v)[3]) {
+  compare_swap(v[0], v[1]);
+  compare_swap(v[0], v[2]);
+  compare_swap(v[1], v[2]);
+}
+template <> inline void sort<4>(uint (&v)[4]) {
+  compare_swap(v[0], v[2]);
+  compare_swap(v[1], v[3]);
+  compare_swap(v[0], v[1]);
+  compare_swap(v[2], v[3]);
+  compare_swap(v[1], v[2]);
+}
+
+template <size_t N> struct Connect {
+  uint n[N];
+};
+
+template <size_t N> struct CanonicalSimplexHash {
+  size_t operator() (const Connect<N> & s) const {
+    uint n[N];
+    std::copy(s.n, s.n + N, n);
+    sort<N>(n);
+    size_t seed = 0;
+    for (size_t i = 0; i < N; ++i) {
+      hash_combine(seed, n[i]);
+    }
+    return seed;
+  }
+};
+
+template <size_t N> struct CanonicalSimplexOrder {
+  bool operator() (const Connect<N> & lhs, const Connect<N> & rhs) const {
+    uint l[N], r[N];
+    std::copy(lhs.n, lhs.n + N, l);
+    std::copy(rhs.n, rhs.n + N, r);
+    sort<N>(l);
+    sort<N>(r);
+    for (size_t i = 0; i < N; ++i) {
+      if (l[i] < r[i]) {
+        return true;
+      }
+      if (r[i] < l[i]) {
+        return false;
+      }
+    }
+    return false;
+  }
+};
+
+template <size_t N> struct CanonicalSimplexEquality {
+  bool operator() (const Connect<N> & lhs, const Connect<N> & rhs) const {
+    uint l[N], r[N];
+    std::copy(lhs.n, lhs.n + N, l);
+    std::copy(rhs.n, rhs.n + N, r);
+    sort<N>(l);
+    sort<N>(r);
+    for (size_t i = 0; i < N; ++i) {
+      if (l[i] != r[i]) {
+        return false;
+      }
+    }
+    return true;
+  }
+};
+
+}  // namespace legacy
+
+///////////////////////////////////////////////////////////////////////////////
+// Benchmarks.                                                               //
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Time inserting the simplices in to a hash set (hash and equality) and
+ * sorting them (order), returning the number of distinct simplices found by
+ * each so that the two implementations can be checked against each other.
+ */
+template <class C, class Hash, class Equality, class Order>
+void bench(const char * name, const std::vector<C> & simplices,
+           size_t & distinctHashed, size_t & distinctSorted)
+{
+  Timer timer;
+  std::unordered_set<C, Hash, Equality> set(simplices.begin(), simplices.end());
+  double hashTime = timer.elapsed();
+  distinctHashed = set.size();
+
+  std::vector<C> sorted(simplices);
+  timer.reset();
+  std::sort(sorted.begin(), sorted.end(), Order());
+  double sortTime = timer.elapsed();
+
+  distinctSorted = 0;
+  Equality equal;
+  for (size_t i = 0; i < sorted.size(); ++i) {
+    if (i == 0 || !equal(sorted[i-1], sorted[i])) {
+      ++distinctSorted;
+    }
+  }
+
+  printf("  %-10s hash set %8.3f s   sort %8.3f s\n", name, hashTime, sortTime);
+}
+
+/**
+ * Simplices with indices drawn from a small range, so that each appears
+ * several times with its indices in different orders (as the faces shared
+ * by neighbouring tetrahedra do).
+ */
+template <size_t N>
+bool compare(size_t count, std::mt19937 & random)
+{
+  std::uniform_int_distribution<uint> index(0, (uint)(2*std::pow(count, 1.0/N)));
+
+  std::vector< ConnectN<N> >      simplices(count);
+  std::vector< legacy::Connect<N> > legacySimplices(count);
+  for (size_t s = 0; s < count; ++s) {
+    for (size_t i = 0; i < N; ++i) {
+      simplices[s].n[i] = legacySimplices[s].n[i] = index(random);
+    }
+  }
+
+  printf("N = %zu, %zu simplices\n", N, count);
+
+  size_t legacyHashed, legacySorted, hashed, sorted;
+  bench< legacy::Connect<N>,
+         legacy::CanonicalSimplexHash<N>,
+         legacy::CanonicalSimplexEquality<N>,
+         legacy::CanonicalSimplexOrder<N> >(
+      "legacy", legacySimplices, legacyHashed, legacySorted);
+  bench< ConnectN<N>,
+         CanonicalSimplexHash< ConnectN<N> >,
+         CanonicalSimplexEquality< ConnectN<N> >,
+         CanonicalSimplexOrder< ConnectN<N> > >(
+      "ConnectN", simplices, hashed, sorted);
+
+  bool agree = legacyHashed == hashed && legacySorted == sorted && hashed == sorted;
+  printf("  distinct %zu %s\n", hashed, agree ? "(agree)" : "(MISMATCH)");
+
+  return agree;
+}
+
+int main(int argc, char * argv[])
+{
+  size_t count = (argc > 1) ? strtoul(argv[1], NULL, 10) : 4000000;
+
+  std::mt19937 random(1234);
+
+  bool agree = compare<2>(count, random);
+  agree = compare<3>(count, random) && agree;
+  agree = compare<4>(count, random) && agree;
+
+  return agree ? 0 : 1;
+}
@@ -0,0 +1,340 @@
+/**
+ * \file   ArrowGlyphs.cpp
+ * \author L. Nagy
+ *
+ * MIT License
+ *
+ * Copyright (c) [2016] Lesleis Nagy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <mutex>
+
+#include <vtkCellArray.h>
+#include <vtkDoubleArray.h>
+#include <vtkIdTypeArray.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkSMPTools.h>
+
+#include "ArrowGlyphs.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// Shared templates.                                                         //
+///////////////////////////////////////////////////////////////////////////////
+
+static std::once_flag                  sTemplateOnce[ArrowTemplate::NDETAIL];
+static std::unique_ptr<ArrowTemplate>  sTemplates[ArrowTemplate::NDETAIL];
+
+/// Shaft and tip resolutions for each level of detail.
+static const int sResolutions[ArrowTemplate::NDETAIL][2] = {
+  { 4,  6},
+  { 6, 12},
+  {10, 30}
+};
+
+const ArrowTemplate & ArrowTemplate::get(Detail detail)
+{
+  std::call_once(sTemplateOnce[detail], [detail]() {
+    sTemplates[detail] = std::make_unique<ArrowTemplate>(
+        sResolutions[detail][0], sResolutions[detail][1]);
+  });
+
+  return *sTemplates[detail];
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Constructor (ArrowTemplate)                                               //
+///////////////////////////////////////////////////////////////////////////////
+
+ArrowTemplate::ArrowTemplate(int shaftResolution, int tipResolution)
+{
+  // Proportions of vtkArrowSource, translated so the arrow is centred.
+  const double tipLength   = 0.35;
+  const double tipRadius   = 0.1;
+  const double shaftRadius = 0.03;
+  const double x0          = -0.5;
+  const double x1          = 0.5 - tipLength;
+  const double x2          = 0.5;
+
+  // Shaft end cap, a fan facing -x.
+  vtkIdType centre = addPoint(x0, 0.0, 0.0, -1.0, 0.0, 0.0);
+  vtkIdType cap    = mPoints.size();
+  for (int i = 0; i < shaftResolution; ++i) {
+    double theta = 2.0*M_PI*i/shaftResolution;
+    addPoint(x0, shaftRadius*cos(theta), shaftRadius*sin(theta), -1.0, 0.0, 0.0);
+  }
+  for (int i = 0; i < shaftResolution; ++i) {
+    int j = (i + 1) % shaftResolution;
+    mTriangles.push_back({centre, cap + j, cap + i});
+  }
+
+  // Shaft, with radial normals.
+  vtkIdType shaft = mPoints.size();
+  for (int i = 0; i < shaftResolution; ++i) {
+    double theta = 2.0*M_PI*i/shaftResolution;
+    double c = cos(theta), s = sin(theta);
+    addPoint(x0, shaftRadius*c, shaftRadius*s, 0.0, c, s);
+    addPoint(x1, shaftRadius*c, shaftRadius*s, 0.0, c, s);
+  }
+  for (int i = 0; i < shaftResolution; ++i) {
+    int j = (i + 1) % shaftResolution;
+    mTriangles.push_back({shaft + 2*i, shaft + 2*j,     shaft + 2*i + 1});
+    mTriangles.push_back({shaft + 2*j, shaft + 2*j + 1, shaft + 2*i + 1});
+  }
+
+  // Back of the tip, an annulus facing -x.
+  vtkIdType base = mPoints.size();
+  for (int i = 0; i < tipResolution; ++i) {
+    double theta = 2.0*M_PI*i/tipResolution;
+    double c = cos(theta), s = sin(theta);
+    addPoint(x1, shaftRadius*c, shaftRadius*s, -1.0, 0.0, 0.0);
+    addPoint(x1, tipRadius*c,   tipRadius*s,   -1.0, 0.0, 0.0);
+  }
+  for (int i = 0; i < tipResolution; ++i) {
+    int j = (i + 1) % tipResolution;
+    mTriangles.push_back({base + 2*i, base + 2*j,     base + 2*i + 1});
+    mTriangles.push_back({base + 2*j, base + 2*j + 1, base + 2*i + 1});
+  }
+
+  // Tip, with smooth cone normals. The apex is repeated for each segment so
+  // that it takes the normal half way round the segment.
+  double len = sqrt(tipRadius*tipRadius + tipLength*tipLength);
+  double na  = tipRadius/len;
+  double nr  = tipLength/len;
+  vtkIdType tip = mPoints.size();
+  for (int i = 0; i < tipResolution; ++i) {
+    double theta = 2.0*M_PI*i/tipResolution;
+    double phi   = 2.0*M_PI*(i + 0.5)/tipResolution;
+    double c = cos(theta), s = sin(theta);
+    addPoint(x1, tipRadius*c, tipRadius*s, na, nr*c, nr*s);
+    addPoint(x2, 0.0, 0.0, na, nr*cos(phi), nr*sin(phi));
+  }
+  for (int i = 0; i < tipResolution; ++i) {
+    int j = (i + 1) % tipResolution;
+    mTriangles.push_back({tip + 2*i, tip + 2*j, tip + 2*i + 1});
+  }
+}
+
+vtkIdType ArrowTemplate::addPoint(
+    double x, double y, double z, double nx, double ny, double nz)
+{
+  mPoints.push_back({.x = x, .y = y, .z = z});
+  mNormals.push_back({.x = nx, .y = ny, .z = nz});
+
+  return mPoints.size() - 1;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Constructor (ArrowGlyphs)                                                 //
+///////////////////////////////////////////////////////////////////////////////
+
+ArrowGlyphs::ArrowGlyphs() :
+  mOutput(vtkSmartPointer<vtkPolyData>::New()), mArrow(NULL), mNInstances(0),
+  mScale(0.0)
+{}
+
+///////////////////////////////////////////////////////////////////////////////
+// Function build()                                                          //
+///////////////////////////////////////////////////////////////////////////////
+
+void ArrowGlyphs::build(
+    const ArrowTemplate & arrow,
+    const VertexField3d & vert,
+    const double        * v,
+    double                scale)
+{
+  build(arrow, vert, v, scale, NULL, vert.size());
+}
+
+void ArrowGlyphs::build(
+    const ArrowTemplate & arrow,
+    const VertexField3d & vert,
+    const double        * v,
+    double                scale,
+    const vtkIdType     * ids,
+    size_t                nids)
+{
+  if (ids != NULL) {
+    mIds.assign(ids, ids + nids);
+  } else {
+    mIds.clear();
+  }
+  mScale = scale;
+
+  allocate(arrow, nids);
+
+  const std::vector<Vertex3d> & tp = arrow.points();
+  const std::vector<Vector3d> & tn = arrow.normals();
+  size_t np = arrow.npoint();
+
+  double * xyz = vtkDoubleArray::SafeDownCast(
+      mOutput->GetPoints()->GetData())->GetPointer(0);
+  double * nrm = vtkDoubleArray::SafeDownCast(
+      mOutput->GetPointData()->GetNormals())->GetPointer(0);
+
+  vtkSMPTools::For(0, nids, [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType g = begin; g < end; ++g) {
+      vtkIdType      i  = ids != NULL ? ids[g] : g;
+      const double * vi = v + 3*i;
+
+      // An orthonormal (right handed) frame with u along the vector.
+      double mag = sqrt(vi[0]*vi[0] + vi[1]*vi[1] + vi[2]*vi[2]);
+      double u[3] = {1.0, 0.0, 0.0};
+      if (mag > 0.0) {
+        u[0] = vi[0]/mag; u[1] = vi[1]/mag; u[2] = vi[2]/mag;
+      }
+      double a[3] = {0.0, 0.0, 0.0};
+      int    k    = fabs(u[0]) < fabs(u[1])
+                  ? (fabs(u[0]) < fabs(u[2]) ? 0 : 2)
+                  : (fabs(u[1]) < fabs(u[2]) ? 1 : 2);
+      a[k] = 1.0;
+      double w1[3] = {u[1]*a[2] - u[2]*a[1],
+                      u[2]*a[0] - u[0]*a[2],
+                      u[0]*a[1] - u[1]*a[0]};
+      double l = sqrt(w1[0]*w1[0] + w1[1]*w1[1] + w1[2]*w1[2]);
+      w1[0] /= l; w1[1] /= l; w1[2] /= l;
+      double w2[3] = {u[1]*w1[2] - u[2]*w1[1],
+                      u[2]*w1[0] - u[0]*w1[2],
+                      u[0]*w1[1] - u[1]*w1[0]};
+
+      double s    = scale*mag;
+      double x[3] = {vert[i].x, vert[i].y, vert[i].z};
+      double * pg = xyz + 3*np*g;
+      double * ng = nrm + 3*np*g;
+      for (size_t p = 0; p < np; ++p) {
+        for (int d = 0; d < 3; ++d) {
+          pg[3*p+d] = x[d]
+                    + s*(tp[p].x*u[d] + tp[p].y*w1[d] + tp[p].z*w2[d]);
+          ng[3*p+d] = tn[p].x*u[d] + tn[p].y*w1[d] + tn[p].z*w2[d];
+        }
+      }
+    }
+  });
+
+  mOutput->GetPoints()->Modified();
+  mOutput->GetPointData()->GetNormals()->Modified();
+  mOutput->Modified();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Function colour()                                                         //
+///////////////////////////////////////////////////////////////////////////////
+
+void ArrowGlyphs::colour(const double * scalar)
+{
+  if (mArrow == NULL) {
+    return;
+  }
+
+  size_t   np = mArrow->npoint();
+  double * sg = vtkDoubleArray::SafeDownCast(
+      mOutput->GetPointData()->GetScalars())->GetPointer(0);
+
+  vtkSMPTools::For(0, mNInstances, [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType g = begin; g < end; ++g) {
+      double s = scalar[mIds.empty() ? g : mIds[g]];
+      std::fill(sg + np*g, sg + np*(g + 1), s);
+    }
+  });
+
+  mOutput->GetPointData()->GetScalars()->Modified();
+  mOutput->Modified();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Function memoryBytes()                                                    //
+///////////////////////////////////////////////////////////////////////////////
+
+size_t ArrowGlyphs::memoryBytes() const
+{
+  // NOTE: VTK reports sizes in KiB.
+  return mOutput->GetActualMemorySize()*1024
+       + mIds.capacity()*sizeof(vtkIdType);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Private functions.                                                        //
+///////////////////////////////////////////////////////////////////////////////
+
+void ArrowGlyphs::allocate(const ArrowTemplate & arrow, size_t ninstances)
+{
+  if (&arrow == mArrow && ninstances == mNInstances) {
+    return;
+  }
+  mArrow      = &arrow;
+  mNInstances = ninstances;
+
+  vtkIdType np      = arrow.npoint();
+  vtkIdType nt      = arrow.ntri();
+  vtkIdType npoints = np*ninstances;
+  vtkIdType ntri    = nt*ninstances;
+
+  vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+  points->SetDataTypeToDouble();
+  points->SetNumberOfPoints(npoints);
+
+  vtkSmartPointer<vtkDoubleArray> normals = vtkSmartPointer<vtkDoubleArray>::New();
+  normals->SetName("Normals");
+  normals->SetNumberOfComponents(3);
+  normals->SetNumberOfTuples(npoints);
+
+  vtkSmartPointer<vtkDoubleArray> scalars = vtkSmartPointer<vtkDoubleArray>::New();
+  scalars->SetName("Scalars");
+  scalars->SetNumberOfComponents(1);
+  scalars->SetNumberOfTuples(npoints);
+  double * s = scalars->GetPointer(0);
+  vtkSMPTools::For(0, npoints, [&](vtkIdType begin, vtkIdType end) {
+    std::fill(s + begin, s + end, 0.0);
+  });
+
+  // The connectivity of every instance is that of the template, offset.
+  vtkSmartPointer<vtkIdTypeArray> offsets = vtkSmartPointer<vtkIdTypeArray>::New();
+  offsets->SetNumberOfValues(ntri + 1);
+  vtkSmartPointer<vtkIdTypeArray> connectivity = vtkSmartPointer<vtkIdTypeArray>::New();
+  connectivity->SetNumberOfValues(3*ntri);
+  vtkIdType * o = offsets->GetPointer(0);
+  vtkIdType * c = connectivity->GetPointer(0);
+
+  const std::vector< std::array<vtkIdType, 3> > & triangles = arrow.triangles();
+  vtkSMPTools::For(0, ninstances, [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType g = begin; g < end; ++g) {
+      for (vtkIdType t = 0; t < nt; ++t) {
+        vtkIdType k = nt*g + t;
+        o[k] = 3*k;
+        for (int j = 0; j < 3; ++j) {
+          c[3*k+j] = np*g + triangles[t][j];
+        }
+      }
+    }
+  });
+  o[ntri] = 3*ntri;
+
+  vtkSmartPointer<vtkCellArray> polys = vtkSmartPointer<vtkCellArray>::New();
+  polys->SetData(offsets, connectivity);
+
+  mOutput->SetPoints(points);
+  mOutput->SetPolys(polys);
+  mOutput->GetPointData()->SetNormals(normals);
+  mOutput->GetPointData()->SetScalars(scalars);
+}
@@ -0,0 +1,166 @@
+/**
+ * \file   ArrowGlyphs.h
+ * \author L. Nagy
+ *
+ * MIT License
+ *
+ * Copyright (c) [2016] Lesleis Nagy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+
+#ifndef ARROW_GLYPHS_H_
+#define ARROW_GLYPHS_H_
+
+#include <array>
+#include <vector>
+
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+#include <vtkType.h>
+
+#include "Data.h"
+
+/**
+ * \brief A unit arrow (length one along +x, centred on the origin) as a
+ *        triangle mesh with per-vertex normals.
+ *
+ * The proportions are those of vtkArrowSource (tip length 0.35, tip radius
+ * 0.1, shaft radius 0.03). Templates are immutable, one per level of detail
+ * is built on first request and shared by every model.
+ */
+class ArrowTemplate
+{
+public:
+  /// Levels of detail.
+  enum Detail {
+    /// Shaft resolution 4, tip resolution 6.
+    COARSE,
+    /// Shaft resolution 6, tip resolution 12.
+    MEDIUM,
+    /// Shaft resolution 10, tip resolution 30.
+    FINE,
+    NDETAIL
+  };
+
+  /**
+   * \brief Return the shared template for a level of detail.
+   */
+  static const ArrowTemplate & get(Detail detail);
+
+  ArrowTemplate(int shaftResolution, int tipResolution);
+
+  ArrowTemplate(const ArrowTemplate &) = delete;
+  ArrowTemplate & operator= (const ArrowTemplate &) = delete;
+
+  size_t npoint() const { return mPoints.size(); }
+
+  size_t ntri() const { return mTriangles.size(); }
+
+  const std::vector<Vertex3d> & points() const { return mPoints; }
+
+  const std::vector<Vector3d> & normals() const { return mNormals; }
+
+  const std::vector< std::array<vtkIdType, 3> > & triangles() const { return mTriangles; }
+
+private:
+  std::vector<Vertex3d>                   mPoints;
+  std::vector<Vector3d>                   mNormals;
+  std::vector< std::array<vtkIdType, 3> > mTriangles;
+
+  vtkIdType addPoint(double x, double y, double z, double nx, double ny, double nz);
+};
+
+/**
+ * \brief Arrow glyphs of a vector field, built natively and in parallel.
+ *
+ * Each instance is a copy of an ArrowTemplate pointing along the vector and
+ * scaled by its magnitude (times a scale factor), cf. vtkGlyph3D with
+ * ScaleByVector. Instances are written straight in to the buffers of the
+ * output, which are (re)allocated only when the template or the number of
+ * instances changes; the connectivity is written at allocation, so
+ * re-scaling rewrites points and normals only and re-colouring only the
+ * (per vertex) scalars.
+ */
+class ArrowGlyphs
+{
+public:
+  ArrowGlyphs();
+
+  ArrowGlyphs(const ArrowGlyphs &) = delete;
+  ArrowGlyphs & operator= (const ArrowGlyphs &) = delete;
+
+  /**
+   * \brief Glyph every vertex.
+   *
+   * \param[in] arrow the arrow template, this must outlive the glyphs.
+   * \param[in] vert  the glyph positions.
+   * \param[in] v     the vectors (three components per vertex).
+   * \param[in] scale the scale factor.
+   */
+  void build(
+      const ArrowTemplate & arrow,
+      const VertexField3d & vert,
+      const double        * v,
+      double                scale);
+
+  /**
+   * \brief As above, but only glyph the given vertices.
+   *
+   * \param[in] ids  the vertices to glyph.
+   * \param[in] nids the number of vertices to glyph.
+   */
+  void build(
+      const ArrowTemplate & arrow,
+      const VertexField3d & vert,
+      const double        * v,
+      double                scale,
+      const vtkIdType     * ids,
+      size_t                nids);
+
+  /**
+   * \brief Colour the glyphs by a scalar field (one value per vertex of the
+   *        field), these become the active scalars of the output.
+   */
+  void colour(const double * scalar);
+
+  /// The glyphs.
+  vtkSmartPointer<vtkPolyData> output() const { return mOutput; }
+
+  /// The scale factor of the last build.
+  double scale() const { return mScale; }
+
+  /// The number of glyphs.
+  size_t size() const { return mNInstances; }
+
+  /// The memory used by the glyphs.
+  size_t memoryBytes() const;
+
+private:
+  vtkSmartPointer<vtkPolyData>  mOutput;
+  const ArrowTemplate         * mArrow;
+  size_t                        mNInstances;
+  double                        mScale;
+  /// The glyphed vertices, empty if every vertex is glyphed.
+  std::vector<vtkIdType>        mIds;
+
+  void allocate(const ArrowTemplate & arrow, size_t ninstances);
+};
+
+#endif  // ARROW_GLYPHS_H_
@@ -0,0 +1,269 @@
+/**
+ * \file   BoundarySurface.cpp
+ * \author L. Nagy
+ *
+ * MIT License
+ *
+ * Copyright (c) [2016] Lesleis Nagy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+#include <vtkSMPTools.h>
+
+#include "BoundarySurface.h"
+
+/// The faces of a tetrahedron, face k is opposite vertex k.
+static const int sTetFaces[4][3] = {{1, 2, 3}, {0, 3, 2}, {0, 1, 3}, {0, 2, 1}};
+
+/// The cosine of the angle between normals beyond which an edge is a feature.
+static const double sFeatureCos = 0.70710678118654752;
+
+/// Find the root of a disjoint set element (with path halving).
+static vtkIdType find_root(std::vector<vtkIdType> & parent, vtkIdType i)
+{
+  while (parent[i] != i) {
+    parent[i] = parent[parent[i]];
+    i = parent[i];
+  }
+  return i;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Constructor                                                               //
+///////////////////////////////////////////////////////////////////////////////
+
+BoundarySurface::BoundarySurface(
+    const VertexField3d   & vert,
+    const ConnectIndices4 & conn) :
+  mArea(0.0),
+  mNPatch(0),
+  mVertexFaceOffsets(vert.size() + 1, 0)
+{
+  vtkIdType ntet = conn.size();
+
+  // Canonical keys of every (tetrahedron, face) pair, sorted so that the two
+  // copies of an interior face are adjacent.
+  std::vector< std::pair<Connect3::Key, vtkIdType> > keys(4*ntet);
+  vtkSMPTools::For(0, ntet, [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType t = begin; t < end; ++t) {
+      for (int k = 0; k < 4; ++k) {
+        Connect3 face = {{conn[t][sTetFaces[k][0]],
+                          conn[t][sTetFaces[k][1]],
+                          conn[t][sTetFaces[k][2]]}};
+        keys[4*t + k] = std::make_pair(face.key(), 4*t + k);
+      }
+    }
+  });
+  vtkSMPTools::Sort(keys.begin(), keys.end(),
+      [](const std::pair<Connect3::Key, vtkIdType> & lhs,
+         const std::pair<Connect3::Key, vtkIdType> & rhs) {
+        return lhs.first < rhs.first
+            || (lhs.first == rhs.first && lhs.second < rhs.second);
+      });
+
+  // A face is on the boundary if its key is unique.
+  vtkIdType nkeys = keys.size();
+  std::vector<unsigned char> boundary(nkeys);
+  vtkSMPTools::For(0, nkeys, [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType i = begin; i < end; ++i) {
+      bool prev = (i > 0)         && keys[i-1].first == keys[i].first;
+      bool next = (i + 1 < nkeys) && keys[i+1].first == keys[i].first;
+      boundary[i] = !prev && !next;
+    }
+  });
+
+  for (vtkIdType i = 0; i < nkeys; ++i) {
+    if (boundary[i]) {
+      mTets.push_back(keys[i].second);
+    }
+  }
+
+  // Outward oriented faces, normals and areas. Listed face orders are
+  // outward for positively oriented tetrahedra, flip them otherwise.
+  size_t nface = mTets.size();
+  mFaces.resize(nface);
+  mNormals.resize(nface);
+  mAreas.resize(nface);
+  vtkSMPTools::For(0, nface, [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType f = begin; f < end; ++f) {
+      vtkIdType t = mTets[f]/4;
+      int       k = mTets[f]%4;
+      mTets[f] = t;
+
+      Connect3 face = {{conn[t][sTetFaces[k][0]],
+                        conn[t][sTetFaces[k][1]],
+                        conn[t][sTetFaces[k][2]]}};
+
+      const Vertex3d & a = vert[face[0]];
+      Vector3d n = cross(vert[face[1]] - a, vert[face[2]] - a);
+      if (dot(n, vert[conn[t][k]] - a) > 0.0) {
+        std::swap(face[1], face[2]);
+        n = n*(-1.0);
+      }
+
+      double twiceArea = norm(n);
+      mFaces[f]   = face;
+      mAreas[f]   = 0.5*twiceArea;
+      mNormals[f] = twiceArea > 0.0 ? n/twiceArea : n;
+    }
+  });
+
+  for (double a : mAreas) {
+    mArea += a;
+  }
+
+  // Vertex to face adjacency (compressed rows).
+  for (const Connect3 & face : mFaces) {
+    for (int k = 0; k < 3; ++k) {
+      mVertexFaceOffsets[face[k] + 1]++;
+    }
+  }
+  for (size_t v = 0; v < vert.size(); ++v) {
+    if (mVertexFaceOffsets[v + 1] > 0) {
+      mVertices.push_back(v);
+    }
+    mVertexFaceOffsets[v + 1] += mVertexFaceOffsets[v];
+  }
+  mVertexFaces.resize(3*nface);
+  std::vector<vtkIdType> fill(mVertexFaceOffsets.begin(), mVertexFaceOffsets.end() - 1);
+  for (size_t f = 0; f < nface; ++f) {
+    for (int k = 0; k < 3; ++k) {
+      mVertexFaces[fill[mFaces[f][k]]++] = f;
+    }
+  }
+
+  setNeighbours();
+
+  setPatches();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Function normalComponent()                                                //
+///////////////////////////////////////////////////////////////////////////////
+
+void BoundarySurface::normalComponent(const double * m, double * mn) const
+{
+  vtkSMPTools::For(0, nface(), [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType f = begin; f < end; ++f) {
+      const Connect3 & face = mFaces[f];
+      const Vector3d & n    = mNormals[f];
+
+      double r = 0.0;
+      for (int k = 0; k < 3; ++k) {
+        const double * mk = m + 3*face[k];
+        r += mk[0]*n.x + mk[1]*n.y + mk[2]*n.z;
+      }
+      mn[f] = r/3.0;
+    }
+  });
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Function patchSum()                                                       //
+///////////////////////////////////////////////////////////////////////////////
+
+void BoundarySurface::patchSum(const double * faceValues, double * result) const
+{
+  std::fill(result, result + mNPatch, 0.0);
+  for (size_t f = 0; f < nface(); ++f) {
+    result[mPatches[f]] += faceValues[f];
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Function memoryBytes()                                                    //
+///////////////////////////////////////////////////////////////////////////////
+
+size_t BoundarySurface::memoryBytes() const
+{
+  return mFaces.capacity()*sizeof(Connect3)
+       + mTets.capacity()*sizeof(vtkIdType)
+       + mVertices.capacity()*sizeof(vtkIdType)
+       + mNormals.capacity()*sizeof(Vector3d)
+       + mAreas.capacity()*sizeof(double)
+       + mNeighbours.capacity()*sizeof(std::array<vtkIdType, 3>)
+       + mPatches.capacity()*sizeof(vtkIdType)
+       + mVertexFaceOffsets.capacity()*sizeof(vtkIdType)
+       + mVertexFaces.capacity()*sizeof(vtkIdType);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Private functions.                                                        //
+///////////////////////////////////////////////////////////////////////////////
+
+void BoundarySurface::setNeighbours()
+{
+  // Canonical keys of every (face, edge) pair, sorted so that the two copies
+  // of an edge are adjacent. Edge k is opposite face vertex k.
+  vtkIdType nkeys = 3*nface();
+  std::vector< std::pair<Connect2::Key, vtkIdType> > keys(nkeys);
+  vtkSMPTools::For(0, nface(), [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType f = begin; f < end; ++f) {
+      for (int k = 0; k < 3; ++k) {
+        Connect2 edge = {{mFaces[f][(k+1)%3], mFaces[f][(k+2)%3]}};
+        keys[3*f + k] = std::make_pair(edge.key(), 3*f + k);
+      }
+    }
+  });
+  vtkSMPTools::Sort(keys.begin(), keys.end());
+
+  // NOTE: on a closed manifold surface every edge is shared by exactly two
+  //       faces, at non-manifold edges faces are paired in key order.
+  mNeighbours.assign(nface(), {-1, -1, -1});
+  for (vtkIdType i = 0; i + 1 < nkeys; ++i) {
+    if (keys[i].first == keys[i+1].first) {
+      vtkIdType a = keys[i].second, b = keys[i+1].second;
+      mNeighbours[a/3][a%3] = b/3;
+      mNeighbours[b/3][b%3] = a/3;
+      ++i;
+    }
+  }
+}
+
+void BoundarySurface::setPatches()
+{
+  std::vector<vtkIdType> parent(nface());
+  for (size_t f = 0; f < nface(); ++f) {
+    parent[f] = f;
+  }
+
+  for (size_t f = 0; f < nface(); ++f) {
+    for (vtkIdType g : mNeighbours[f]) {
+      if (g < 0 || dot(mNormals[f], mNormals[g]) < sFeatureCos) {
+        continue;
+      }
+      vtkIdType rf = find_root(parent, f), rg = find_root(parent, g);
+      if (rf != rg) {
+        parent[std::max(rf, rg)] = std::min(rf, rg);
+      }
+    }
+  }
+
+  // Number the patches in order of their first face.
+  mPatches.resize(nface());
+  for (size_t f = 0; f < nface(); ++f) {
+    vtkIdType r = find_root(parent, f);
+    mPatches[f] = (r == (vtkIdType)f) ? mNPatch++ : mPatches[r];
+  }
+}
@@ -0,0 +1,142 @@
+/**
+ * \file   BoundarySurface.h
+ * \author L. Nagy
+ *
+ * MIT License
+ *
+ * Copyright (c) [2016] Lesleis Nagy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+
+#ifndef BOUNDARY_SURFACE_H_
+#define BOUNDARY_SURFACE_H_
+
+#include <array>
+#include <vector>
+
+#include <vtkType.h>
+
+#include "Data.h"
+
+/**
+ * \brief The boundary surface of a tetrahedral mesh, i.e. the triangular
+ *        faces used by exactly one tetrahedron.
+ *
+ * Faces are found by sorting the canonical keys of all tetrahedron faces
+ * (in parallel) so that shared faces are adjacent. Boundary faces are
+ * oriented with outward normals and each boundary vertex knows the faces
+ * around it, so face quantities can be gathered to vertices. Faces are split
+ * in to patches, i.e. smooth pieces of the surface bounded by feature edges
+ * (e.g. the faces of a cube, or separate particles).
+ */
+class BoundarySurface
+{
+public:
+  BoundarySurface(const VertexField3d & vert, const ConnectIndices4 & conn);
+
+  size_t nface() const { return mFaces.size(); }
+
+  /// The faces, ordered so that their normals point out of the mesh.
+  const ConnectIndices3 & faces() const { return mFaces; }
+
+  /// The vertices on the surface, in increasing order.
+  const std::vector<vtkIdType> & vertices() const { return mVertices; }
+
+  /// The tetrahedron each face belongs to.
+  const std::vector<vtkIdType> & tets() const { return mTets; }
+
+  /// The unit outward normal of each face.
+  const std::vector<Vector3d> & normals() const { return mNormals; }
+
+  /// The area of each face.
+  const std::vector<double> & areas() const { return mAreas; }
+
+  /// The total area of the surface.
+  double area() const { return mArea; }
+
+  /**
+   * \brief The faces sharing an edge with each face, neighbour k is across
+   *        the edge opposite face vertex k (-1 if there is none).
+   */
+  const std::vector< std::array<vtkIdType, 3> > & neighbours() const { return mNeighbours; }
+
+  /// The number of patches.
+  size_t npatch() const { return mNPatch; }
+
+  /**
+   * \brief The patch of each face, patches are separated by edges at which
+   *        the normal turns by more than 45 degrees.
+   */
+  const std::vector<vtkIdType> & patches() const { return mPatches; }
+
+  /**
+   * \brief Sum per-face values over each patch.
+   *
+   * \param[in]  faceValues a value per face.
+   * \param[out] result     the sum over each patch (npatch() entries).
+   */
+  void patchSum(const double * faceValues, double * result) const;
+
+  /**
+   * \brief Compute the normal component m.n of a nodal vector field on each
+   *        face (exact for the face average of a P1 field).
+   *
+   * \param[in]  m  the nodal field (3 components per vertex).
+   * \param[out] mn the normal component on each face (nface() entries).
+   */
+  void normalComponent(const double * m, double * mn) const;
+
+  /**
+   * \brief The area weighted average of per-face values over the faces
+   *        around vertex v, zero if v is not on the surface.
+   */
+  double gather(vtkIdType v, const double * faceValues) const
+  {
+    double r = 0.0, a = 0.0;
+    for (vtkIdType k = mVertexFaceOffsets[v]; k < mVertexFaceOffsets[v+1]; ++k) {
+      vtkIdType f = mVertexFaces[k];
+      r += mAreas[f]*faceValues[f];
+      a += mAreas[f];
+    }
+    return a > 0.0 ? r/a : 0.0;
+  }
+
+  /// The memory used by the surface.
+  size_t memoryBytes() const;
+
+private:
+  ConnectIndices3            mFaces;
+  std::vector<vtkIdType>     mTets;
+  std::vector<vtkIdType>     mVertices;
+  std::vector<Vector3d>      mNormals;
+  std::vector<double>        mAreas;
+  double                     mArea;
+  std::vector< std::array<vtkIdType, 3> > mNeighbours;
+  size_t                     mNPatch;
+  std::vector<vtkIdType>     mPatches;
+  std::vector<vtkIdType>     mVertexFaceOffsets;
+  std::vector<vtkIdType>     mVertexFaces;
+
+  void setNeighbours();
+
+  void setPatches();
+};
+
+#endif  // BOUNDARY_SURFACE_H_
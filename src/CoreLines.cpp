@@ -0,0 +1,301 @@
+/**
+ * \file   CoreLines.cpp
+ * \author L. Nagy
+ *
+ * MIT License
+ *
+ * Copyright (c) [2016] Lesleis Nagy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+#include <vector>
+
+#include <vtkCellArray.h>
+#include <vtkDoubleArray.h>
+#include <vtkIdTypeArray.h>
+#include <vtkPoints.h>
+#include <vtkSMPThreadLocal.h>
+#include <vtkSMPTools.h>
+
+#include "CoreLines.h"
+#include "DebugMacros.h"
+
+/// The faces of a tetrahedron.
+static const int sTetFaces[4][3] = {{1, 2, 3}, {0, 3, 2}, {0, 1, 3}, {0, 2, 1}};
+
+/**
+ * A piece of core line, crossing a tetrahedron from one face to another.
+ */
+struct CoreSegment {
+  vtkIdType tet;
+  Connect3  face[2];
+  Vertex3d  point[2];
+};
+
+typedef std::unordered_map<
+    Connect3, vtkIdType,
+    CanonicalSimplexHash<Connect3>, CanonicalSimplexEquality<Connect3> > FaceIndexMap;
+
+///////////////////////////////////////////////////////////////////////////////
+// Function face_crossing()                                                  //
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Find the point at which the (linearly interpolated) components u and v
+ * both vanish on a face, the face must be in canonical order so that both
+ * tetrahedra sharing it find exactly the same point.
+ */
+static bool face_crossing(
+    const VertexField3d & vert,
+    const Connect3      & face,
+    const double        * u,
+    const double        * v,
+    Vertex3d            & p)
+{
+  double u0 = u[face[0]], u1 = u[face[1]] - u0, u2 = u[face[2]] - u0;
+  double v0 = v[face[0]], v1 = v[face[1]] - v0, v2 = v[face[2]] - v0;
+
+  // Solve u0 + s u1 + t u2 = 0, v0 + s v1 + t v2 = 0.
+  double det = u1*v2 - u2*v1;
+  if (det == 0.0) {
+    return false;
+  }
+  double s = (u2*v0 - u0*v2)/det;
+  double t = (u0*v1 - u1*v0)/det;
+  if (s < 0.0 || t < 0.0 || s + t > 1.0) {
+    return false;
+  }
+
+  const Vertex3d & a = vert[face[0]];
+  p = (1.0 - s - t)*a + s*vert[face[1]] + t*vert[face[2]];
+
+  return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Functor to find core segments.                                            //
+///////////////////////////////////////////////////////////////////////////////
+
+struct CoreSegmentFunctor
+{
+  const VertexField3d                           & vert;
+  const ConnectIndices4                         & conn;
+  const double                                  * u;
+  const double                                  * v;
+  vtkSMPThreadLocal< std::vector<CoreSegment> >   local;
+  std::vector<CoreSegment>                        segments;
+
+  CoreSegmentFunctor(
+      const VertexField3d   & vert,
+      const ConnectIndices4 & conn,
+      const double          * u,
+      const double          * v) :
+    vert(vert), conn(conn), u(u), v(v)
+  {}
+
+  // Thread locals are default constructed (empty) buffers.
+  void Initialize() {}
+
+  void operator() (vtkIdType begin, vtkIdType end)
+  {
+    std::vector<CoreSegment> & buffer = local.Local();
+    for (vtkIdType t = begin; t < end; ++t) {
+      const Connect4 & c = conn[t];
+
+      // Both components must change sign in the tetrahedron.
+      double umin = u[c[0]], umax = umin, vmin = v[c[0]], vmax = vmin;
+      for (int k = 1; k < 4; ++k) {
+        umin = std::min(umin, u[c[k]]);
+        umax = std::max(umax, u[c[k]]);
+        vmin = std::min(vmin, v[c[k]]);
+        vmax = std::max(vmax, v[c[k]]);
+      }
+      if (umin > 0.0 || umax < 0.0 || vmin > 0.0 || vmax < 0.0) {
+        continue;
+      }
+
+      CoreSegment segment;
+      segment.tet = t;
+      int ncross = 0;
+      for (int k = 0; k < 4 && ncross <= 2; ++k) {
+        Connect3 face = Connect3({{c[sTetFaces[k][0]],
+                                   c[sTetFaces[k][1]],
+                                   c[sTetFaces[k][2]]}}).canonical();
+        Vertex3d p;
+        if (face_crossing(vert, face, u, v, p)) {
+          if (ncross < 2) {
+            segment.face[ncross]  = face;
+            segment.point[ncross] = p;
+          }
+          ++ncross;
+        }
+      }
+
+      // NOTE: a line passing exactly through an edge or vertex is seen by
+      //       more than two faces, such (measure zero) cases are dropped.
+      if (ncross == 2) {
+        buffer.push_back(segment);
+      }
+    }
+  }
+
+  void Reduce()
+  {
+    segments.clear();
+    for (const std::vector<CoreSegment> & buffer : local) {
+      segments.insert(segments.end(), buffer.begin(), buffer.end());
+    }
+
+    // Thread buffers are filled in a non-deterministic order.
+    std::sort(segments.begin(), segments.end(),
+        [](const CoreSegment & lhs, const CoreSegment & rhs) {
+          return lhs.tet < rhs.tet;
+        });
+  }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// Function core_lines()                                                     //
+///////////////////////////////////////////////////////////////////////////////
+
+vtkSmartPointer<vtkPolyData> core_lines(
+    const VertexField3d   & vert,
+    const ConnectIndices4 & conn,
+    const double          * m,
+    const Vector3d        & axis)
+{
+  // Components of m in a frame (e1, e2, axis).
+  Vector3d a  = cnormalize(axis);
+  Vector3d e1 = fabs(a.x) < 0.9 ? Vector3d({.x = 1.0, .y = 0.0, .z = 0.0})
+                                : Vector3d({.x = 0.0, .y = 1.0, .z = 0.0});
+  e1 = cnormalize(e1 - dot(e1, a)*a);
+  Vector3d e2 = cross(a, e1);
+
+  vtkIdType nvert = vert.size();
+  std::vector<double> u(nvert), v(nvert);
+  vtkSMPTools::For(0, nvert, [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType i = begin; i < end; ++i) {
+      const double * mi = m + 3*i;
+      u[i] = mi[0]*e1.x + mi[1]*e1.y + mi[2]*e1.z;
+      v[i] = mi[0]*e2.x + mi[1]*e2.y + mi[2]*e2.z;
+    }
+  });
+
+  CoreSegmentFunctor functor(vert, conn, u.data(), v.data());
+  vtkSMPTools::For(0, conn.size(), functor);
+  const std::vector<CoreSegment> & segments = functor.segments;
+
+  // Weld segment end points through the faces they lie on.
+  FaceIndexMap          index;
+  std::vector<Vertex3d> points;
+  std::vector<vtkIdType> ends(2*segments.size());
+  for (size_t s = 0; s < segments.size(); ++s) {
+    for (int k = 0; k < 2; ++k) {
+      auto it = index.emplace(segments[s].face[k], (vtkIdType)points.size());
+      if (it.second) {
+        points.push_back(segments[s].point[k]);
+      }
+      ends[2*s + k] = it.first->second;
+    }
+  }
+
+  // Point to segment adjacency (compressed rows).
+  vtkIdType npoints = points.size();
+  std::vector<vtkIdType> offsets(npoints + 1, 0), incident(ends.size());
+  for (vtkIdType p : ends) {
+    offsets[p + 1]++;
+  }
+  for (vtkIdType p = 0; p < npoints; ++p) {
+    offsets[p + 1] += offsets[p];
+  }
+  std::vector<vtkIdType> fill(offsets.begin(), offsets.end() - 1);
+  for (size_t e = 0; e < ends.size(); ++e) {
+    incident[fill[ends[e]]++] = e/2;
+  }
+
+  // Walk the segments in to polylines, open lines start at points that are
+  // not shared by exactly two segments (i.e. at the surface), what is left
+  // afterwards are closed loops.
+  std::vector<unsigned char> used(segments.size(), 0);
+  std::vector<vtkIdType>     lineOffsets(1, 0), lineConnectivity;
+  auto walk = [&](vtkIdType p, vtkIdType s) {
+    lineConnectivity.push_back(p);
+    while (s >= 0 && !used[s]) {
+      used[s] = 1;
+      p = (ends[2*s] == p) ? ends[2*s + 1] : ends[2*s];
+      lineConnectivity.push_back(p);
+
+      s = -1;
+      if (offsets[p + 1] - offsets[p] == 2) {
+        for (vtkIdType k = offsets[p]; k < offsets[p + 1]; ++k) {
+          if (!used[incident[k]]) {
+            s = incident[k];
+          }
+        }
+      }
+    }
+    lineOffsets.push_back(lineConnectivity.size());
+  };
+  for (int closed = 0; closed < 2; ++closed) {
+    for (vtkIdType p = 0; p < npoints; ++p) {
+      if (!closed && offsets[p + 1] - offsets[p] == 2) {
+        continue;
+      }
+      for (vtkIdType k = offsets[p]; k < offsets[p + 1]; ++k) {
+        if (!used[incident[k]]) {
+          walk(p, incident[k]);
+        }
+      }
+    }
+  }
+
+  // Copy to VTK.
+  vtkSmartPointer<vtkPoints> vtkpoints = vtkSmartPointer<vtkPoints>::New();
+  vtkpoints->SetDataTypeToDouble();
+  vtkpoints->SetNumberOfPoints(npoints);
+  double * xyz = vtkDoubleArray::SafeDownCast(vtkpoints->GetData())->GetPointer(0);
+  for (vtkIdType p = 0; p < npoints; ++p) {
+    xyz[3*p]   = points[p].x;
+    xyz[3*p+1] = points[p].y;
+    xyz[3*p+2] = points[p].z;
+  }
+
+  vtkSmartPointer<vtkIdTypeArray> o = vtkSmartPointer<vtkIdTypeArray>::New();
+  o->SetNumberOfValues(lineOffsets.size());
+  std::copy(lineOffsets.begin(), lineOffsets.end(), o->GetPointer(0));
+  vtkSmartPointer<vtkIdTypeArray> c = vtkSmartPointer<vtkIdTypeArray>::New();
+  c->SetNumberOfValues(lineConnectivity.size());
+  std::copy(lineConnectivity.begin(), lineConnectivity.end(), c->GetPointer(0));
+
+  vtkSmartPointer<vtkCellArray> lines = vtkSmartPointer<vtkCellArray>::New();
+  lines->SetData(o, c);
+
+  vtkSmartPointer<vtkPolyData> polyData = vtkSmartPointer<vtkPolyData>::New();
+  polyData->SetPoints(vtkpoints);
+  polyData->SetLines(lines);
+
+  DEBUG("Core lines: " << lineOffsets.size() - 1 << " lines, "
+        << segments.size() << " segments");
+
+  return polyData;
+}
@@ -0,0 +1,60 @@
+/**
+ * \file   CoreLines.h
+ * \author L. Nagy
+ *
+ * MIT License
+ *
+ * Copyright (c) [2016] Lesleis Nagy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+
+#ifndef CORE_LINES_H_
+#define CORE_LINES_H_
+
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+
+#include "Data.h"
+
+/**
+ * \brief Extract vortex core lines, i.e. the curves on which the components
+ *        of the magnetisation perpendicular to an axis both vanish.
+ *
+ * Both components are linear in each tetrahedron so their common zero set
+ * is a straight segment, which crosses two of the faces of the tetrahedron.
+ * Tetrahedra in which either component does not change sign are rejected
+ * up front, crossings are found on the faces of the remaining tetrahedra in
+ * parallel (with per-thread segment buffers) and segments are stitched in
+ * to polylines through the faces they share.
+ *
+ * \param[in] vert the mesh vertices.
+ * \param[in] conn the mesh tetrahedra.
+ * \param[in] m    the magnetisation (3 components per vertex).
+ * \param[in] axis the (approximate) direction of the cores.
+ *
+ * \return the core lines, one polyline per core.
+ */
+vtkSmartPointer<vtkPolyData> core_lines(
+    const VertexField3d   & vert,
+    const ConnectIndices4 & conn,
+    const double          * m,
+    const Vector3d        & axis);
+
+#endif  // CORE_LINES_H_
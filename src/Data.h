@@ -11,7 +11,13 @@
 #define DATA_H_
 
 #include <cmath>
+#include <cstddef>
+#include <cstdint>
 
+#include <array>
+#include <memory_resource>
+#include <type_traits>
+#include <utility>
 #include <vector>
 #include <unordered_set>
 
@@ -19,300 +25,203 @@
 
 #include "Utilities.h"
 
-inline void compare_swap(uint & a, uint & b) {
-  if (a > b) {
-    uint tmp = a;
-    a = b;
-    b = tmp;
-  }
+constexpr void compare_swap(uint & a, uint & b) {
+  uint lo = (a < b) ? a : b;
+  uint hi = (a < b) ? b : a;
+  a = lo;
+  b = hi;
 }
 
-template <class T> struct CanonicalSimplexHash;
-template <class T> struct CanonicalSimplexOrder;
-template <class T> struct CanonicalSimplexEquality;
-
 /**
- * Structure defining a connectivity for two indices (e.g. a line).
+ * A single comparator of a sorting network, a pair of indices (i < j).
  */
-struct Connect2 {
-  /// First index.
-  unsigned int n0;
-  /// Second index.
-  unsigned int n1;
+struct Comparator {
+  unsigned char i;
+  unsigned char j;
 };
-inline bool operator == (const Connect2 & lhs, const Connect2 & rhs) {
-  return lhs.n0 == rhs.n0 && lhs.n1 == rhs.n1;
-}
-template <> struct CanonicalSimplexHash<Connect2> {
-  size_t operator() (Connect2 const& s) const {
-    size_t seed = 0;
 
-    uint n0 = s.n0;
-    uint n1 = s.n1;
-
-    // Sorting network for two values.
-    compare_swap(n0, n1);
-
-    // Build hash
-    hash_combine(seed, n0);
-    hash_combine(seed, n1);
-
-    return seed;
+/**
+ * Generate the comparators of a sorting network for N values at compile time.
+ * The comparators are those of Batcher's odd-even merge sort over the next
+ * power of two above N, with any comparator touching an index >= N discarded
+ * (equivalent to padding the input with +infinity). This gives 1 comparator
+ * for N=2, 3 for N=3 and 5 for N=4, i.e. the optimal networks.
+ */
+template <size_t N, class F>
+constexpr void generate_sorting_network(F emit) {
+  size_t n = 1;
+  while (n < N) {
+    n <<= 1;
   }
-};
-template <> struct CanonicalSimplexOrder<Connect2> {
-  bool operator () (const Connect2 &lhs, const Connect2 &rhs) const {
-    uint ln0 = lhs.n0, ln1 = lhs.n1;
-    uint rn0 = rhs.n0, rn1 = rhs.n1;
-
-    // Sort left hand side and right hand side indices in to canonical order
-    compare_swap(ln0, ln1);
-
-    compare_swap(rn0, rn1);
 
-    // Perform lexographical ordering on the canonical ordering.
-    if (ln0 < rn0) {
-      return true;
-    }
-    if (rn0 < ln0) {
-      return false;
+  for (size_t p = 1; p < n; p <<= 1) {
+    for (size_t k = p; k >= 1; k >>= 1) {
+      for (size_t j = k % p; j + k < n; j += 2*k) {
+        for (size_t i = 0; i < k && i + j + k < n; ++i) {
+          if ((i + j)/(2*p) == (i + j + k)/(2*p) && (i + j + k) < N) {
+            emit(i + j, i + j + k);
+          }
+        }
+      }
     }
+  }
+}
 
-    if (ln1 < rn1) {
-      return true;
-    }
+template <size_t N>
+constexpr size_t sorting_network_size() {
+  size_t c = 0;
+  generate_sorting_network<N>([&c](size_t, size_t) { ++c; });
+  return c;
+}
 
-    return false;
-  }
-};
-template <> struct CanonicalSimplexEquality<Connect2> {
-  bool operator() (const Connect2 &lhs, const Connect2 &rhs) const {
-    uint ln0 = lhs.n0, ln1 = lhs.n1;
-    uint rn0 = rhs.n0, rn1 = rhs.n1;
+template <size_t N>
+constexpr std::array<Comparator, sorting_network_size<N>()> sorting_network() {
+  std::array<Comparator, sorting_network_size<N>()> result{};
+  size_t c = 0;
+  generate_sorting_network<N>([&result, &c](size_t i, size_t j) {
+    result[c].i = (unsigned char)i;
+    result[c].j = (unsigned char)j;
+    ++c;
+  });
+  return result;
+}
 
-    // Sort left hand side and right hand side indices in to canonical order
-    compare_swap(ln0, ln1);
+/**
+ * Compile time sorting network for N values, the comparators are fully
+ * unrolled in to a sequence of compare_swap calls.
+ */
+template <size_t N>
+struct SortingNetwork {
+  static constexpr std::array<Comparator, sorting_network_size<N>()> network =
+    sorting_network<N>();
 
-    compare_swap(rn0, rn1);
+  static constexpr void sort(uint (&v)[N]) {
+    apply(v, std::make_index_sequence<network.size()>{});
+  }
 
-    // Perform equality.
-    return ln0 == rn0 && ln1 == rn1;
+private:
+  template <size_t... C>
+  static constexpr void apply(uint (&v)[N], std::index_sequence<C...>) {
+    (compare_swap(v[network[C].i], v[network[C].j]), ...);
   }
 };
 
 /**
- * Structure defining connectivity for three indices (e.g. a triangle).
+ * A 128 bit key, used to store the canonical form of three and four index
+ * connectivities.
  */
-struct Connect3 {
-  /// First index.
-  unsigned int n0;
-  /// Second index.
-  unsigned int n1;
-  /// Third index.
-  unsigned int n2;
+struct Key128 {
+  /// Most significant word.
+  uint64_t hi;
+  /// Least significant word.
+  uint64_t lo;
 };
-inline bool operator == (const Connect3 & lhs, const Connect3 & rhs) {
-  return lhs.n0 == rhs.n0 && lhs.n1 == rhs.n1 && lhs.n2 == rhs.n2;
+inline bool operator == (const Key128 & lhs, const Key128 & rhs) {
+  return ((lhs.hi ^ rhs.hi) | (lhs.lo ^ rhs.lo)) == 0;
+}
+inline bool operator < (const Key128 & lhs, const Key128 & rhs) {
+  return (lhs.hi < rhs.hi) || (lhs.hi == rhs.hi && lhs.lo < rhs.lo);
 }
-template <> struct CanonicalSimplexHash<Connect3> {
-  size_t operator() (Connect3 const& s) const {
-    size_t seed = 0;
-
-    uint n0 = s.n0;
-    uint n1 = s.n1;
-    uint n2 = s.n2;
 
-    // Sorting network for 3 values.
-    compare_swap(n0, n1);
-    compare_swap(n0, n2);
-    compare_swap(n1, n2);
+/**
+ * Multiply-mix functions used to hash canonical keys.
+ */
+inline size_t mix_key(uint64_t k) {
+  k *= 0xff51afd7ed558ccdULL;
+  return (size_t)(k ^ (k >> 32));
+}
 
-    // Build hash.
-    hash_combine(seed, n0);
-    hash_combine(seed, n1);
-    hash_combine(seed, n2);
+inline size_t mix_key(Key128 const& k) {
+  return mix_key(k.hi ^ (k.lo * 0x9e3779b97f4a7c15ULL));
+}
 
-    return seed;
-  }
-};
-template <> struct CanonicalSimplexOrder<Connect3> {
-  bool operator() (const Connect3 &lhs, const Connect3 &rhs) const {
-    uint ln0 = lhs.n0, ln1 = lhs.n1, ln2 = lhs.n2;
-    uint rn0 = rhs.n0, rn1 = rhs.n1, rn2 = rhs.n2;
-
-    // Sort left hand side and right hand side indices in to canonical order
-    compare_swap(ln0, ln1);
-    compare_swap(ln0, ln2);
-    compare_swap(ln1, ln2);
-
-    compare_swap(rn0, rn1);
-    compare_swap(rn0, rn2);
-    compare_swap(rn1, rn2);
-
-    // Perform lexographical ordering on the canonically ordered indices.
-    if (ln0 < rn0) {
-      return true;
-    }
+/**
+ * Structure defining connectivity for N indices, e.g. a line (N = 2), a
+ * triangle (N = 3) or a tetrahedron (N = 4).
+ */
+template <size_t N>
+struct ConnectN {
+  static_assert(N >= 2 && N <= 4, "ConnectN supports two to four indices");
 
-    if (rn0 < ln0) {
-      return false;
-    }
+  /// The packed canonical key type.
+  typedef typename std::conditional<N <= 2, uint64_t, Key128>::type Key;
 
-    // ln0 and rn0 are equal
-    if (ln1 < rn1) {
-      return true;
-    }
+  /// The indices.
+  uint n[N];
 
-    if (rn1 < ln1) {
-      return false;
-    }
+  uint & operator[] (size_t i) { return n[i]; }
 
-    // ln1 and rn1 are equal
-    if (ln2 < rn2) {
-      return true;
-    }
+  uint operator[] (size_t i) const { return n[i]; }
 
-    return false;
+  /**
+   * Return the connectivity with its indices sorted in to canonical order.
+   */
+  constexpr ConnectN canonical() const {
+    ConnectN c = *this;
+    SortingNetwork<N>::sort(c.n);
+    return c;
   }
-};
-template <> struct CanonicalSimplexEquality<Connect3> {
-  bool operator() (const Connect3 &lhs, const Connect3 &rhs) const {
-    uint ln0 = lhs.n0, ln1 = lhs.n1, ln2 = lhs.n2;
-    uint rn0 = rhs.n0, rn1 = rhs.n1, rn2 = rhs.n2;
-
-    // Sort left hand side and right hand side indices in to canonical order
-    compare_swap(ln0, ln1);
-    compare_swap(ln0, ln2);
-    compare_swap(ln1, ln2);
 
-    compare_swap(rn0, rn1);
-    compare_swap(rn0, rn2);
-    compare_swap(rn1, rn2);
-
-    // printf("Equality test: %i, %i, %i == %i, %i, %i\n", ln0, ln1, ln2, rn0, rn1, rn2);
-
-    return ln0 == rn0 && ln1 == rn1 && ln2 == rn2;
+  /**
+   * Return the canonical form packed in to a single key, keys compare in the
+   * same (lexicographical) order as canonically sorted indices.
+   */
+  constexpr Key key() const {
+    ConnectN c = canonical();
+    if constexpr (N == 2) {
+      return ((uint64_t)c.n[0] << 32) | (uint64_t)c.n[1];
+    } else if constexpr (N == 3) {
+      return {((uint64_t)c.n[0] << 32) | (uint64_t)c.n[1],
+              ((uint64_t)c.n[2] << 32)};
+    } else {
+      return {((uint64_t)c.n[0] << 32) | (uint64_t)c.n[1],
+              ((uint64_t)c.n[2] << 32) | (uint64_t)c.n[3]};
+    }
   }
 };
+template <size_t N>
+inline bool operator == (const ConnectN<N> & lhs, const ConnectN<N> & rhs) {
+  for (size_t i = 0; i < N; ++i) {
+    if (lhs.n[i] != rhs.n[i]) {
+      return false;
+    }
+  }
+  return true;
+}
 
 /**
- * Structure definining connectivity for four indices (e.g. a tetrahedron).
+ * Hash, ordering and equality of connectivities in canonical order (i.e. 
+ * irrespective of the order in which indices are given).
  */
-struct Connect4 {
-  /// First index.
-  unsigned int n0;
-  /// Second index.
-  unsigned int n1;
-  /// Third index.
-  unsigned int n2;
-  /// Fourth index.
-  unsigned int n3;
-};
-inline bool operator == (const Connect4 & lhs, const Connect4 & rhs) {
-  return lhs.n0 == rhs.n0 && lhs.n1 == rhs.n1
-      && lhs.n2 == rhs.n2 && lhs.n3 == rhs.n3;
-}
-template <> struct CanonicalSimplexHash<Connect4> {
-  size_t operator() (Connect4 const & s) const {
-    size_t seed = 0;
-
-    uint n0 = s.n0;
-    uint n1 = s.n1;
-    uint n2 = s.n2;
-    uint n3 = s.n3;
-
-    // Sorting network for 4 values.
-    compare_swap(n0, n2);
-    compare_swap(n1, n3);
-    compare_swap(n0, n1);
-    compare_swap(n2, n3);
-    compare_swap(n1, n2);
-
-    // Build hash.
-    hash_combine(seed, n0);
-    hash_combine(seed, n1);
-    hash_combine(seed, n2);
-    hash_combine(seed, n3);
-
-    return seed;
+template <class T> struct CanonicalSimplexHash;
+template <class T> struct CanonicalSimplexOrder;
+template <class T> struct CanonicalSimplexEquality;
+
+template <size_t N> struct CanonicalSimplexHash< ConnectN<N> > {
+  size_t operator() (ConnectN<N> const& s) const {
+    return mix_key(s.key());
   }
 };
-template <> struct CanonicalSimplexOrder<Connect4> {
-  bool operator() (const Connect4 &lhs, const Connect4 &rhs) const {
-    uint ln0 = lhs.n0, ln1 = lhs.n1, ln2 = lhs.n2, ln3 = lhs.n3;
-    uint rn0 = rhs.n0, rn1 = rhs.n1, rn2 = rhs.n2, rn3 = rhs.n3;
-
-    // Sort left hand side and right hand side indices in to canonical order
-    compare_swap(ln0, ln2);
-    compare_swap(ln1, ln3);
-    compare_swap(ln0, ln1);
-    compare_swap(ln2, ln3);
-    compare_swap(ln1, ln2);
-
-    compare_swap(rn0, rn2);
-    compare_swap(rn1, rn3);
-    compare_swap(rn0, rn1);
-    compare_swap(rn2, rn3);
-    compare_swap(rn1, rn2);
-
-    // Perform lexographical ordering on the canonically ordered indices.
-    if (ln0 < rn0) {
-      return true;
-    }
-
-    if (rn0 < ln0) {
-      return false;
-    }
-
-    // ln0 and rn0 are equal
-    if (ln1 < rn1) {
-      return true;
-    }
-
-    if (rn1 < ln1) {
-      return false;
-    }
-
-    // ln1 and rn1 are equal
-    if (ln2 < rn2) {
-      return true;
-    }
-
-    if (rn2 < ln2) {
-      return false;
-    }
-
-    // ln2 and rn2 are equal
-    if (ln3 < rn3) {
-      return true;
-    }
-
-    return false;
+template <size_t N> struct CanonicalSimplexOrder< ConnectN<N> > {
+  bool operator() (const ConnectN<N> & lhs, const ConnectN<N> & rhs) const {
+    return lhs.key() < rhs.key();
   }
 };
-template <> struct CanonicalSimplexEquality<Connect4> {
-  bool operator() (const Connect4 &lhs, const Connect4 &rhs) const {
-    uint ln0 = lhs.n0, ln1 = lhs.n1, ln2 = lhs.n2, ln3 = lhs.n3;
-    uint rn0 = rhs.n0, rn1 = rhs.n1, rn2 = rhs.n2, rn3 = rhs.n3;
-
-    // Sort left hand side and right hand side indices in to canonical order
-    compare_swap(ln0, ln2);
-    compare_swap(ln1, ln3);
-    compare_swap(ln0, ln1);
-    compare_swap(ln2, ln3);
-    compare_swap(ln1, ln2);
-
-    compare_swap(rn0, rn2);
-    compare_swap(rn1, rn3);
-    compare_swap(rn0, rn1);
-    compare_swap(rn2, rn3);
-    compare_swap(rn1, rn2);
-
-    // Perform equality.
-    return ln0 == rn0 && ln1 == rn1 && ln2 == rn2 && ln3 == rn3;
+template <size_t N> struct CanonicalSimplexEquality< ConnectN<N> > {
+  bool operator() (const ConnectN<N> & lhs, const ConnectN<N> & rhs) const {
+    return lhs.key() == rhs.key();
   }
 };
 
+/// Connectivity for two indices (e.g. a line).
+typedef ConnectN<2> Connect2;
+
+/// Connectivity for three indices (e.g. a triangle).
+typedef ConnectN<3> Connect3;
+
+/// Connectivity for four indices (e.g. a tetrahedron).
+typedef ConnectN<4> Connect4;
+
 /**
  * Structure defining a two-component vector.
  */
@@ -527,16 +436,44 @@ inline Vector3d cross(Vector3d const& lhs, Vector3d const& rhs) {
           .z = (lhs.x * rhs.y) - (lhs.y * rhs.x)};
 }
 
-typedef std::vector<Connect2>                ConnectIndices2;
-typedef std::vector<Connect3>                ConnectIndices3;
-typedef std::vector<Connect4>                ConnectIndices4;
+/**
+ * Compute the barycentric coordinates of a point with respect to the
+ * tetrahedron (a, b, c, d). Returns false if the tetrahedron is degenerate.
+ */
+inline bool barycentric(Vertex3d const& a, Vertex3d const& b,
+                        Vertex3d const& c, Vertex3d const& d,
+                        Vertex3d const& p, double bary[4]) {
+  Vector3d v0 = b - a;
+  Vector3d v1 = c - a;
+  Vector3d v2 = d - a;
+  Vector3d vp = p - a;
+
+  double det = dot(v0, cross(v1, v2));
+  if (det == 0.0) {
+    return false;
+  }
+
+  bary[1] = dot(vp, cross(v1, v2))/det;
+  bary[2] = dot(v0, cross(vp, v2))/det;
+  bary[3] = dot(v0, cross(v1, vp))/det;
+  bary[0] = 1.0 - bary[1] - bary[2] - bary[3];
+
+  return true;
+}
+
+// Containers are polymorphic (pmr) vectors, by default these allocate from
+// the global heap but a load may supply a std::pmr::memory_resource (e.g. a
+// MemoryArena) so that its temporaries are released in one shot.
+typedef std::pmr::vector<Connect2>                     ConnectIndices2;
+typedef std::pmr::vector<Connect3>                     ConnectIndices3;
+typedef std::pmr::vector<Connect4>                     ConnectIndices4;
 
-typedef std::vector<Vector2d>                VectorField2d;
-typedef std::vector< std::vector<Vector2d> > VectorFields2d;
-typedef std::vector<Vertex2d>                VertexField2d;
+typedef std::pmr::vector<Vector2d>                     VectorField2d;
+typedef std::pmr::vector< std::pmr::vector<Vector2d> > VectorFields2d;
+typedef std::pmr::vector<Vertex2d>                     VertexField2d;
 
-typedef std::vector<Vector3d>                VectorField3d;
-typedef std::vector< std::vector<Vector3d> > VectorFields3d;
-typedef std::vector<Vertex3d>                VertexField3d;
+typedef std::pmr::vector<Vector3d>                     VectorField3d;
+typedef std::pmr::vector< std::pmr::vector<Vector3d> > VectorFields3d;
+typedef std::pmr::vector<Vertex3d>                     VertexField3d;
 
 #endif  // DATA_H_
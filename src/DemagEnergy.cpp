@@ -0,0 +1,287 @@
+/**
+ * \file   DemagEnergy.cpp
+ * \author L. Nagy
+ *
+ * MIT License
+ *
+ * Copyright (c) [2016] Lesleis Nagy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+#include <tuple>
+
+#include <vtkSMPThreadLocal.h>
+#include <vtkSMPTools.h>
+
+#include "DebugMacros.h"
+#include "DemagEnergy.h"
+#include "FFT.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// Cache of kernels, keyed by grid dimensions.                               //
+///////////////////////////////////////////////////////////////////////////////
+
+// NOTE: the cache holds the kernels, models compute their energies one at a
+//       time and only briefly hold a kernel. Most recently requested first.
+typedef std::tuple<size_t, size_t, size_t> GridShape;
+
+static std::mutex                                                  sKernelMutex;
+static std::vector< std::pair< GridShape,
+    std::shared_ptr<const DemagKernel> > >                         sKernels;
+
+///////////////////////////////////////////////////////////////////////////////
+// Function acquire()                                                        //
+///////////////////////////////////////////////////////////////////////////////
+
+std::shared_ptr<const DemagKernel> DemagKernel::acquire(const size_t dims[3])
+{
+  GridShape shape(dims[0], dims[1], dims[2]);
+
+  std::lock_guard<std::mutex> lock(sKernelMutex);
+
+  for (auto it = sKernels.begin(); it != sKernels.end(); ++it) {
+    if (it->first == shape) {
+      std::rotate(sKernels.begin(), it, it + 1);
+      return sKernels.front().second;
+    }
+  }
+
+  DEBUG("Building demag kernel for " << dims[0] << "x" << dims[1] << "x" << dims[2]);
+  auto kernel = std::make_shared<const DemagKernel>(dims);
+  sKernels.insert(sKernels.begin(), {shape, kernel});
+  if (sKernels.size() > Kernels) {
+    sKernels.pop_back();
+  }
+
+  return kernel;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Function cacheBytes()                                                     //
+///////////////////////////////////////////////////////////////////////////////
+
+size_t DemagKernel::cacheBytes()
+{
+  std::lock_guard<std::mutex> lock(sKernelMutex);
+
+  size_t bytes = 0;
+  for (auto & k : sKernels) {
+    bytes += k.second->memoryBytes();
+  }
+
+  return bytes;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Constructor                                                               //
+///////////////////////////////////////////////////////////////////////////////
+
+DemagKernel::DemagKernel(const size_t dims[3])
+{
+  // Zero padding to at least 2n - 1 avoids wrap around in the convolution.
+  for (int d = 0; d < 3; ++d) {
+    mDims[d]   = dims[d];
+    mPadded[d] = next_pow2(2*dims[d] - 1);
+  }
+  size_t size = mPadded[0]*mPadded[1]*mPadded[2];
+
+  for (auto & n : mN) {
+    n.assign(size, 0.0);
+  }
+
+  // Dipole tensor N = (I - 3 r r^T/r^2)/(4 pi r^3), in units of cells (the
+  // cell volume is 1), at every (wrapped) offset.
+  vtkSMPTools::For(0, size, [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType idx = begin; idx < end; ++idx) {
+      size_t a = idx % mPadded[0];
+      size_t b = (idx / mPadded[0]) % mPadded[1];
+      size_t c = idx / (mPadded[0]*mPadded[1]);
+
+      double x = (a <= mPadded[0]/2) ? (double)a : (double)a - mPadded[0];
+      double y = (b <= mPadded[1]/2) ? (double)b : (double)b - mPadded[1];
+      double z = (c <= mPadded[2]/2) ? (double)c : (double)c - mPadded[2];
+
+      double r2 = x*x + y*y + z*z;
+      if (r2 == 0.0) {
+        mN[0][idx] = mN[1][idx] = mN[2][idx] = 1.0/3.0;
+        continue;
+      }
+
+      double s = 1.0/(4.0*M_PI*r2*sqrt(r2));
+      mN[0][idx] = s*(1.0 - 3.0*x*x/r2);
+      mN[1][idx] = s*(1.0 - 3.0*y*y/r2);
+      mN[2][idx] = s*(1.0 - 3.0*z*z/r2);
+      mN[3][idx] = s*(-3.0*x*y/r2);
+      mN[4][idx] = s*(-3.0*x*z/r2);
+      mN[5][idx] = s*(-3.0*y*z/r2);
+    }
+  });
+
+  for (auto & n : mN) {
+    fft3d(n.data(), mPadded, false);
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Function convolve()                                                       //
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Parallel reduction of sum_x m(x).h(x) over the unpadded grid.
+ */
+struct ContractFunctor
+{
+  const VectorField3d                       & m;
+  const std::vector< std::complex<double> > * h;
+  const size_t                              * dims;
+  const size_t                              * padded;
+  vtkSMPThreadLocal<double>                   local;
+  double                                      result;
+
+  ContractFunctor(
+      const VectorField3d                       & m,
+      const std::vector< std::complex<double> > * h,
+      const size_t                              * dims,
+      const size_t                              * padded) :
+    m(m), h(h), dims(dims), padded(padded), local(0.0), result(0.0)
+  {}
+
+  // Thread locals are initialised from their exemplar.
+  void Initialize() {}
+
+  void operator() (vtkIdType begin, vtkIdType end)
+  {
+    double & sum = local.Local();
+    for (vtkIdType idx = begin; idx < end; ++idx) {
+      size_t i = idx % dims[0];
+      size_t j = (idx / dims[0]) % dims[1];
+      size_t k = idx / (dims[0]*dims[1]);
+      size_t p = (k*padded[1] + j)*padded[0] + i;
+      sum += m[idx].x*h[0][p].real() + m[idx].y*h[1][p].real() + m[idx].z*h[2][p].real();
+    }
+  }
+
+  void Reduce()
+  {
+    result = 0.0;
+    for (double sum : local) {
+      result += sum;
+    }
+  }
+};
+
+double DemagKernel::convolve(const VectorField3d & m) const
+{
+  size_t size = mPadded[0]*mPadded[1]*mPadded[2];
+
+  // Zero padded, transformed components of m.
+  std::vector< std::complex<double> > mhat[3];
+  for (int d = 0; d < 3; ++d) {
+    mhat[d].assign(size, 0.0);
+  }
+  vtkSMPTools::For(0, m.size(), [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType idx = begin; idx < end; ++idx) {
+      size_t i = idx % mDims[0];
+      size_t j = (idx / mDims[0]) % mDims[1];
+      size_t k = idx / (mDims[0]*mDims[1]);
+      size_t p = (k*mPadded[1] + j)*mPadded[0] + i;
+      mhat[0][p] = m[idx].x;
+      mhat[1][p] = m[idx].y;
+      mhat[2][p] = m[idx].z;
+    }
+  });
+  for (int d = 0; d < 3; ++d) {
+    fft3d(mhat[d].data(), mPadded, false);
+  }
+
+  // (N*m)^ = N^ m^, in place (each frequency is independent).
+  vtkSMPTools::For(0, size, [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType f = begin; f < end; ++f) {
+      std::complex<double> mx = mhat[0][f], my = mhat[1][f], mz = mhat[2][f];
+      mhat[0][f] = mN[0][f]*mx + mN[3][f]*my + mN[4][f]*mz;
+      mhat[1][f] = mN[3][f]*mx + mN[1][f]*my + mN[5][f]*mz;
+      mhat[2][f] = mN[4][f]*mx + mN[5][f]*my + mN[2][f]*mz;
+    }
+  });
+  for (int d = 0; d < 3; ++d) {
+    fft3d(mhat[d].data(), mPadded, true);
+  }
+
+  ContractFunctor contract(m, mhat, mDims, mPadded);
+  vtkSMPTools::For(0, m.size(), contract);
+
+  return contract.result;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Function memoryBytes()                                                    //
+///////////////////////////////////////////////////////////////////////////////
+
+size_t DemagKernel::memoryBytes() const
+{
+  size_t bytes = 0;
+  for (auto & n : mN) {
+    bytes += n.capacity()*sizeof(std::complex<double>);
+  }
+  return bytes;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Functions demag_grid() and demag_energy()                                 //
+///////////////////////////////////////////////////////////////////////////////
+
+UniformGrid demag_grid(const BoundingBox & box, size_t maxCells)
+{
+  double maxExtent = 0.0;
+  for (int d = 0; d < 3; ++d) {
+    maxExtent = std::max(maxExtent, box.hi[d] - box.lo[d]);
+  }
+  double h = (maxExtent > 0.0) ? maxExtent/maxCells : 1.0;
+
+  UniformGrid grid;
+  for (int d = 0; d < 3; ++d) {
+    double extent = std::max(box.hi[d] - box.lo[d], 0.0);
+    grid.dims[d]    = std::max((size_t)ceil(extent/h - 1E-9), (size_t)1);
+    grid.spacing[d] = h;
+    // Centre the cells on the box.
+    grid.origin[d]  = 0.5*(box.lo[d] + box.hi[d]) - 0.5*(grid.dims[d] - 1)*h;
+  }
+
+  return grid;
+}
+
+double demag_energy(
+    const UniformGrid   & grid,
+    const VectorField3d & m,
+    double                ms,
+    double                lengthScale)
+{
+  const double mu0 = 4.0E-7*M_PI;
+
+  double h     = grid.spacing[0]*lengthScale;
+  double vcell = h*h*h;
+
+  std::shared_ptr<const DemagKernel> kernel = DemagKernel::acquire(grid.dims);
+
+  return 0.5*mu0*ms*ms*vcell*kernel->convolve(m);
+}
@@ -0,0 +1,110 @@
+/**
+ * \file   DemagEnergy.h
+ * \author L. Nagy
+ *
+ * MIT License
+ *
+ * Copyright (c) [2016] Lesleis Nagy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+
+#ifndef DEMAG_ENERGY_H_
+#define DEMAG_ENERGY_H_
+
+#include <complex>
+#include <memory>
+#include <vector>
+
+#include "Data.h"
+#include "GridResampler.h"
+#include "TetBVH.h"
+
+/**
+ * \brief The Fourier transform of the demagnetising tensor on a zero padded
+ *        grid of cubic cells.
+ *
+ * The tensor between distinct cells is that of point dipoles, the self term
+ * is N = I/3 (a sphere of equal volume), which is adequate for a rough
+ * estimate. For cubic cells the tensor depends only on offsets in cells, so
+ * transforms are cached per grid shape, see acquire().
+ */
+class DemagKernel
+{
+public:
+  /// The number of kernels (i.e. grid shapes) kept.
+  static const size_t Kernels = 4;
+
+  /**
+   * \brief Return the (cached) kernel for grids with the given dimensions.
+   *        Only the most recently requested Kernels grid shapes are kept.
+   */
+  static std::shared_ptr<const DemagKernel> acquire(const size_t dims[3]);
+
+  /// The memory used by the cached kernels.
+  static size_t cacheBytes();
+
+  explicit DemagKernel(const size_t dims[3]);
+
+  DemagKernel(const DemagKernel &) = delete;
+  DemagKernel & operator= (const DemagKernel &) = delete;
+
+  /**
+   * \brief Compute sum_x m(x).(N*m)(x) over the grid, by convolution with the
+   *        tensor using (parallel) FFTs.
+   *
+   * \param[in] m the field on the (unpadded) grid, x varying fastest.
+   */
+  double convolve(const VectorField3d & m) const;
+
+  /// The memory used by the kernel.
+  size_t memoryBytes() const;
+
+private:
+  size_t                              mDims[3];
+  size_t                              mPadded[3];
+  /// The transformed tensor components xx, yy, zz, xy, xz, yz.
+  std::vector< std::complex<double> > mN[6];
+};
+
+/**
+ * \brief Create a grid of cubic cells (nodes at cell centres) covering a
+ *        bounding box, with at most maxCells cells along its longest side.
+ */
+UniformGrid demag_grid(const BoundingBox & box, size_t maxCells);
+
+/**
+ * \brief Estimate the magnetostatic (demagnetising) energy of a field sampled
+ *        at the cell centres of a grid of cubic cells (zero outside the
+ *        body), E = mu0/2 Ms^2 sum_x V_cell m(x).(N*m)(x).
+ *
+ * \param[in] grid        the grid (see demag_grid()).
+ * \param[in] m           the (unit) magnetisation at the cell centres.
+ * \param[in] ms          the saturation magnetisation (A/m).
+ * \param[in] lengthScale the length of one grid unit (m).
+ *
+ * \return the energy (J).
+ */
+double demag_energy(
+    const UniformGrid   & grid,
+    const VectorField3d & m,
+    double                ms,
+    double                lengthScale);
+
+#endif  // DEMAG_ENERGY_H_
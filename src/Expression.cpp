@@ -0,0 +1,554 @@
+/**
+ * \file   Expression.cpp
+ * \author L. Nagy
+ *
+ * MIT License
+ *
+ * Copyright (c) [2016] Lesleis Nagy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+
+#include <vtkSMPThreadLocal.h>
+#include <vtkSMPTools.h>
+
+#include "Expression.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// Compiler (recursive descent, emitting code as it parses).                 //
+///////////////////////////////////////////////////////////////////////////////
+
+class ExpressionCompiler
+{
+public:
+  ExpressionCompiler(const std::string & source, std::vector<Expression::Program> & programs) :
+    mSource(source), mPos(0), mPrograms(programs)
+  {}
+
+  void compile()
+  {
+    Expression::Program program;
+    mCurrent = &program;
+
+    next();
+    program.result = expr();
+    if (mToken != END) {
+      error("unexpected '" + mText + "'");
+    }
+
+    mPrograms.push_back(program);
+  }
+
+private:
+  enum Token {
+    END, NUMBER, IDENT, LPAREN, RPAREN, COMMA, PLUS, MINUS, TIMES, DIVIDE,
+    BAR, PERIOD, DOT, CROSS, HAT
+  };
+
+  typedef Expression::Value Value;
+  typedef Expression::Op    Op;
+
+  const std::string                  & mSource;
+  size_t                               mPos;
+  std::vector<Expression::Program>   & mPrograms;
+  Expression::Program                * mCurrent;
+
+  Token                                mToken;
+  std::string                          mText;
+  double                               mNumber;
+
+  [[noreturn]] void error(const std::string & message) const
+  {
+    throw ExpressionParseException(
+        "Expression error at position " + std::to_string(mPos) + ": " + message);
+  }
+
+  /// Read the next token.
+  void next()
+  {
+    while (mPos < mSource.size() && isspace((unsigned char)mSource[mPos])) {
+      ++mPos;
+    }
+
+    mText.clear();
+    if (mPos == mSource.size()) {
+      mToken = END;
+      return;
+    }
+
+    char c = mSource[mPos];
+    if (isdigit((unsigned char)c) || (c == '.' && mPos + 1 < mSource.size()
+                                      && isdigit((unsigned char)mSource[mPos + 1]))) {
+      char * end;
+      mNumber = strtod(mSource.c_str() + mPos, &end);
+      mText   = mSource.substr(mPos, end - (mSource.c_str() + mPos));
+      mPos    = end - mSource.c_str();
+      mToken  = NUMBER;
+      return;
+    }
+
+    if (isalpha((unsigned char)c) || c == '_') {
+      size_t start = mPos;
+      while (mPos < mSource.size()
+             && (isalnum((unsigned char)mSource[mPos]) || mSource[mPos] == '_')) {
+        ++mPos;
+      }
+      mText  = mSource.substr(start, mPos - start);
+      mToken = IDENT;
+      return;
+    }
+
+    // UTF-8 operators: middle dot, multiplication sign, combining circumflex.
+    static const struct { const char * text; Token token; } utf8[] = {
+      {"\xc2\xb7", DOT}, {"\xc3\x97", CROSS}, {"\xcc\x82", HAT}
+    };
+    for (const auto & u : utf8) {
+      if (mSource.compare(mPos, 2, u.text) == 0) {
+        mText   = u.text;
+        mToken  = u.token;
+        mPos   += 2;
+        return;
+      }
+    }
+
+    mText = std::string(1, c);
+    ++mPos;
+    switch (c) {
+      case '(': mToken = LPAREN; return;
+      case ')': mToken = RPAREN; return;
+      case ',': mToken = COMMA;  return;
+      case '+': mToken = PLUS;   return;
+      case '-': mToken = MINUS;  return;
+      case '*': mToken = TIMES;  return;
+      case '/': mToken = DIVIDE; return;
+      case '|': mToken = BAR;    return;
+      case '.': mToken = PERIOD; return;
+    }
+    error("unexpected '" + mText + "'");
+  }
+
+  void expect(Token token, const char * text)
+  {
+    if (mToken != token) {
+      error(std::string("expected '") + text + "'");
+    }
+    next();
+  }
+
+  ///////////////////////////////////////////////////////////////////////////
+  // Code generation.                                                      //
+  ///////////////////////////////////////////////////////////////////////////
+
+  int emit(Op op, int a = 0, int b = 0, double c = 0.0)
+  {
+    mCurrent->code.push_back({op, a, b, c});
+    return mCurrent->code.size() - 1;
+  }
+
+  static Value scalar(int r) { return {1, {r, r, r}}; }
+
+  static Value vector(int x, int y, int z) { return {3, {x, y, z}}; }
+
+  Value componentwise(Op op, const Value & u, const Value & v)
+  {
+    if (u.n == 1 && v.n == 1) {
+      return scalar(emit(op, u.reg[0], v.reg[0]));
+    }
+    int r[3];
+    for (int k = 0; k < 3; ++k) {
+      r[k] = emit(op, u.reg[u.n == 3 ? k : 0], v.reg[v.n == 3 ? k : 0]);
+    }
+    return vector(r[0], r[1], r[2]);
+  }
+
+  Value add(const Value & u, const Value & v, Op op)
+  {
+    if (u.n != v.n) {
+      error("can not add or subtract a scalar and a vector");
+    }
+    return componentwise(op, u, v);
+  }
+
+  Value multiply(const Value & u, const Value & v)
+  {
+    if (u.n == 3 && v.n == 3) {
+      error("use dot() or cross() to multiply vectors");
+    }
+    return componentwise(Expression::MUL, u, v);
+  }
+
+  Value divide(const Value & u, const Value & v)
+  {
+    if (v.n == 3) {
+      error("can not divide by a vector");
+    }
+    return componentwise(Expression::DIV, u, v);
+  }
+
+  Value dot(const Value & u, const Value & v)
+  {
+    if (u.n != 3 || v.n != 3) {
+      error("dot product of non-vectors");
+    }
+    int r = emit(Expression::MUL, u.reg[0], v.reg[0]);
+    for (int k = 1; k < 3; ++k) {
+      r = emit(Expression::ADD, r, emit(Expression::MUL, u.reg[k], v.reg[k]));
+    }
+    return scalar(r);
+  }
+
+  Value cross(const Value & u, const Value & v)
+  {
+    if (u.n != 3 || v.n != 3) {
+      error("cross product of non-vectors");
+    }
+    int r[3];
+    for (int k = 0; k < 3; ++k) {
+      int i = (k + 1)%3, j = (k + 2)%3;
+      r[k] = emit(Expression::SUB,
+                  emit(Expression::MUL, u.reg[i], v.reg[j]),
+                  emit(Expression::MUL, u.reg[j], v.reg[i]));
+    }
+    return vector(r[0], r[1], r[2]);
+  }
+
+  Value norm(const Value & u)
+  {
+    if (u.n == 1) {
+      return scalar(emit(Expression::ABS, u.reg[0]));
+    }
+    return scalar(emit(Expression::SQRT, dot(u, u).reg[0]));
+  }
+
+  Value hat(const Value & u)
+  {
+    if (u.n != 3) {
+      error("unit vector of a scalar");
+    }
+    return divide(u, norm(u));
+  }
+
+  ///////////////////////////////////////////////////////////////////////////
+  // Grammar.                                                              //
+  ///////////////////////////////////////////////////////////////////////////
+
+  // expr := term (('+' | '-') term)*
+  Value expr()
+  {
+    Value u = term();
+    while (mToken == PLUS || mToken == MINUS) {
+      Op op = (mToken == PLUS) ? Expression::ADD : Expression::SUB;
+      next();
+      u = add(u, term(), op);
+    }
+    return u;
+  }
+
+  // term := unary (('*' | '/' | '·' | '×') unary)*
+  Value term()
+  {
+    Value u = unary();
+    while (mToken == TIMES || mToken == DIVIDE || mToken == DOT || mToken == CROSS) {
+      Token op = mToken;
+      next();
+      Value v = unary();
+      switch (op) {
+        case TIMES:  u = multiply(u, v); break;
+        case DIVIDE: u = divide(u, v);   break;
+        case DOT:    u = dot(u, v);      break;
+        default:     u = cross(u, v);    break;
+      }
+    }
+    return u;
+  }
+
+  // unary := '-' unary | postfix
+  Value unary()
+  {
+    if (mToken == MINUS) {
+      next();
+      Value u = unary();
+      int r[3];
+      for (int k = 0; k < u.n; ++k) {
+        r[k] = emit(Expression::NEG, u.reg[k]);
+      }
+      return u.n == 1 ? scalar(r[0]) : vector(r[0], r[1], r[2]);
+    }
+    return postfix();
+  }
+
+  // postfix := primary ('.' ('x' | 'y' | 'z') | '̂')*
+  Value postfix()
+  {
+    Value u = primary();
+    for (;;) {
+      if (mToken == PERIOD) {
+        next();
+        if (u.n != 3 || mToken != IDENT || mText.size() != 1
+            || mText[0] < 'x' || mText[0] > 'z') {
+          error("expected a vector component (x, y or z)");
+        }
+        u = scalar(u.reg[mText[0] - 'x']);
+        next();
+      } else if (mToken == HAT) {
+        next();
+        u = hat(u);
+      } else {
+        return u;
+      }
+    }
+  }
+
+  /// The arguments of a function, either in parentheses or a single unary.
+  std::vector<Value> arguments(size_t nargs)
+  {
+    std::vector<Value> args;
+    if (mToken != LPAREN) {
+      if (nargs != 1) {
+        error("expected '('");
+      }
+      args.push_back(unary());
+      return args;
+    }
+
+    next();
+    args.push_back(expr());
+    while (mToken == COMMA) {
+      next();
+      args.push_back(expr());
+    }
+    expect(RPAREN, ")");
+
+    if (args.size() != nargs) {
+      error("wrong number of arguments");
+    }
+    return args;
+  }
+
+  // primary := number | name | function arguments | '(' expr ')' | '|' expr '|'
+  Value primary()
+  {
+    if (mToken == NUMBER) {
+      double c = mNumber;
+      next();
+      return scalar(emit(Expression::CONST, 0, 0, c));
+    }
+
+    if (mToken == LPAREN) {
+      next();
+      Value u = expr();
+      expect(RPAREN, ")");
+      return u;
+    }
+
+    if (mToken == BAR) {
+      next();
+      Value u = expr();
+      expect(BAR, "|");
+      return norm(u);
+    }
+
+    if (mToken != IDENT) {
+      error(mToken == END ? "unexpected end of expression" : "unexpected '" + mText + "'");
+    }
+
+    std::string name = mText;
+    next();
+
+    // Variables.
+    if (name == "m") {
+      return vector(emit(Expression::LOAD_M, 0),
+                    emit(Expression::LOAD_M, 1),
+                    emit(Expression::LOAD_M, 2));
+    }
+    if (name == "r") {
+      return vector(emit(Expression::LOAD_R, 0),
+                    emit(Expression::LOAD_R, 1),
+                    emit(Expression::LOAD_R, 2));
+    }
+    if (name == "mx" || name == "my" || name == "mz") {
+      return scalar(emit(Expression::LOAD_M, name[1] - 'x'));
+    }
+    if (name == "x" || name == "y" || name == "z") {
+      return scalar(emit(Expression::LOAD_R, name[0] - 'x'));
+    }
+    if (name == "pi") {
+      return scalar(emit(Expression::CONST, 0, 0, M_PI));
+    }
+
+    // Functions.
+    if (name == "curl") {
+      // The argument is compiled to its own program, which is evaluated
+      // (and differentiated) before this one.
+      Expression::Program   program;
+      Expression::Program * current = mCurrent;
+      mCurrent = &program;
+      std::vector<Value> args = arguments(1);
+      mCurrent = current;
+
+      if (args[0].n != 3) {
+        error("curl of a scalar");
+      }
+      program.result = args[0];
+      mPrograms.push_back(program);
+
+      int input = mPrograms.size() - 1;
+      return vector(emit(Expression::LOAD_INPUT, input, 0),
+                    emit(Expression::LOAD_INPUT, input, 1),
+                    emit(Expression::LOAD_INPUT, input, 2));
+    }
+    if (name == "dot")   { auto a = arguments(2); return dot(a[0], a[1]); }
+    if (name == "cross") { auto a = arguments(2); return cross(a[0], a[1]); }
+    if (name == "norm")  { auto a = arguments(1); return norm(a[0]); }
+    if (name == "hat")   { auto a = arguments(1); return hat(a[0]); }
+    if (name == "abs" || name == "sqrt") {
+      auto a = arguments(1);
+      if (a[0].n != 1) {
+        error(name + " of a vector");
+      }
+      return scalar(emit(name == "abs" ? Expression::ABS : Expression::SQRT, a[0].reg[0]));
+    }
+
+    error("unknown name '" + name + "'");
+  }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// Constructor                                                               //
+///////////////////////////////////////////////////////////////////////////////
+
+Expression::Expression(const std::string & source) :
+  mSource(source)
+{
+  ExpressionCompiler compiler(mSource, mPrograms);
+  compiler.compile();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Function evaluate()                                                       //
+///////////////////////////////////////////////////////////////////////////////
+
+void Expression::evaluate(
+    const VertexField3d & vert,
+    const TetGeometry   & geometry,
+    const double        * m,
+    double              * result) const
+{
+  // Evaluate and differentiate the arguments of curls.
+  std::vector< std::vector<double> > inputs(mPrograms.size());
+  std::vector<double> argument;
+  for (size_t p = 0; p + 1 < mPrograms.size(); ++p) {
+    argument.resize(3*vert.size());
+    run(mPrograms[p], vert, m, inputs, argument.data());
+
+    inputs[p].resize(3*vert.size());
+    geometry.nodalCurl(argument.data(), inputs[p].data());
+  }
+
+  run(mPrograms.back(), vert, m, inputs, result);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Private functions.                                                        //
+///////////////////////////////////////////////////////////////////////////////
+
+void Expression::run(
+    const Program                            & program,
+    const VertexField3d                      & vert,
+    const double                             * m,
+    const std::vector< std::vector<double> > & inputs,
+    double                                   * result) const
+{
+  const size_t B     = BlockSize;
+  size_t       nvert = vert.size();
+  size_t       nreg  = program.code.size();
+
+  vtkSMPThreadLocal< std::vector<double> > registers;
+  vtkSMPTools::For(0, (nvert + B - 1)/B, [&](vtkIdType begin, vtkIdType end) {
+    std::vector<double> & file = registers.Local();
+    file.resize(nreg*B);
+
+    for (vtkIdType block = begin; block < end; ++block) {
+      size_t first = block*B;
+      size_t n     = std::min(B, nvert - first);
+
+      for (size_t i = 0; i < nreg; ++i) {
+        const Instruction & in = program.code[i];
+        double       * d = file.data() + i*B;
+        const double * a = file.data() + in.a*B;
+        const double * b = file.data() + in.b*B;
+
+        switch (in.op) {
+          case CONST:
+            std::fill(d, d + n, in.c);
+            break;
+          case LOAD_M:
+            for (size_t j = 0; j < n; ++j) { d[j] = m[3*(first + j) + in.a]; }
+            break;
+          case LOAD_R:
+            for (size_t j = 0; j < n; ++j) {
+              const Vertex3d & v = vert[first + j];
+              d[j] = (in.a == 0) ? v.x : (in.a == 1) ? v.y : v.z;
+            }
+            break;
+          case LOAD_INPUT: {
+            const double * f = inputs[in.a].data();
+            for (size_t j = 0; j < n; ++j) { d[j] = f[3*(first + j) + in.b]; }
+            break;
+          }
+          case ADD:
+            for (size_t j = 0; j < n; ++j) { d[j] = a[j] + b[j]; }
+            break;
+          case SUB:
+            for (size_t j = 0; j < n; ++j) { d[j] = a[j] - b[j]; }
+            break;
+          case MUL:
+            for (size_t j = 0; j < n; ++j) { d[j] = a[j]*b[j]; }
+            break;
+          case DIV:
+            for (size_t j = 0; j < n; ++j) { d[j] = (b[j] != 0.0) ? a[j]/b[j] : 0.0; }
+            break;
+          case NEG:
+            for (size_t j = 0; j < n; ++j) { d[j] = -a[j]; }
+            break;
+          case SQRT:
+            for (size_t j = 0; j < n; ++j) { d[j] = sqrt(a[j]); }
+            break;
+          case ABS:
+            for (size_t j = 0; j < n; ++j) { d[j] = fabs(a[j]); }
+            break;
+        }
+      }
+
+      // Interleave the result.
+      const Value & r = program.result;
+      for (int k = 0; k < r.n; ++k) {
+        const double * s = file.data() + r.reg[k]*B;
+        for (size_t j = 0; j < n; ++j) {
+          result[r.n*(first + j) + k] = s[j];
+        }
+      }
+    }
+  });
+}
@@ -0,0 +1,143 @@
+/**
+ * \file   Expression.h
+ * \author L. Nagy
+ *
+ * MIT License
+ *
+ * Copyright (c) [2016] Lesleis Nagy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+
+#ifndef EXPRESSION_H_
+#define EXPRESSION_H_
+
+#include <exception>
+#include <string>
+#include <vector>
+
+#include "Data.h"
+#include "TetGeometry.h"
+
+/**
+ * \brief Exception class thrown if an expression can not be compiled.
+ */
+class ExpressionParseException : public std::exception {
+ public:
+    ExpressionParseException(std::string info):m_info(info) {}
+    ~ExpressionParseException() throw() {}
+
+    const char* what() const throw() {
+      return m_info.c_str();
+    }
+ private:
+    std::string m_info;
+};
+
+/**
+ * \brief A compiled expression for a derived (nodal) field.
+ *
+ * Expressions are built from
+ *   - the magnetisation m (components mx, my, mz) and position r (x, y, z),
+ *   - numbers, pi, + - * / and parentheses,
+ *   - dot(a, b) or a · b, cross(a, b) or a × b, norm(a) or |a|,
+ *     hat(a) or â (the unit vector), curl(a), abs(s), sqrt(s),
+ *   - components a.x, a.y and a.z of vectors,
+ * where single argument functions may be applied without parentheses, e.g.
+ * "mz", "|curl m|" or "m · hat(r)". Division by zero gives zero.
+ *
+ * An expression is compiled to a flat program of scalar operations, vector
+ * operations are expanded component wise. The program is run over blocks of
+ * BlockSize vertices (in parallel) and each operation is a tight loop over
+ * a block of structure of arrays registers, which the compiler vectorises.
+ * The argument of a curl is compiled to its own program, evaluated at every
+ * vertex first and differentiated with the mesh operators.
+ */
+class Expression
+{
+public:
+  /// The number of vertices evaluated together.
+  static const size_t BlockSize = 256;
+
+  /**
+   * \brief Compile an expression.
+   *
+   * \throws ExpressionParseException if the expression is not valid.
+   */
+  explicit Expression(const std::string & source);
+
+  /// The expression source.
+  const std::string & source() const { return mSource; }
+
+  /// The number of components of the result (one or three).
+  int ncomp() const { return mPrograms.back().result.n; }
+
+  /**
+   * \brief Evaluate the expression at every vertex of a mesh.
+   *
+   * \param[in]  vert     the mesh vertices.
+   * \param[in]  geometry the mesh operators (for curl).
+   * \param[in]  m        the magnetisation (3 components per vertex).
+   * \param[out] result   the result (ncomp() components per vertex).
+   */
+  void evaluate(
+      const VertexField3d & vert,
+      const TetGeometry   & geometry,
+      const double        * m,
+      double              * result) const;
+
+  enum Op {
+    CONST, LOAD_M, LOAD_R, LOAD_INPUT, ADD, SUB, MUL, DIV, NEG, SQRT, ABS
+  };
+
+  /// An operation, its result is the register with the same index.
+  struct Instruction {
+    Op     op;
+    /// Operand registers (or component/input indices for loads).
+    int    a;
+    int    b;
+    /// The value of a constant.
+    double c;
+  };
+
+  /// A scalar (one register) or vector (three registers) value.
+  struct Value {
+    int n;
+    int reg[3];
+  };
+
+  struct Program {
+    std::vector<Instruction> code;
+    Value                    result;
+  };
+
+private:
+  std::string          mSource;
+  /// The programs for curl arguments, in evaluation order, then the main one.
+  std::vector<Program> mPrograms;
+
+  void run(
+      const Program                            & program,
+      const VertexField3d                      & vert,
+      const double                             * m,
+      const std::vector< std::vector<double> > & inputs,
+      double                                   * result) const;
+};
+
+#endif  // EXPRESSION_H_
@@ -0,0 +1,130 @@
+/**
+ * \file   FFT.cpp
+ * \author L. Nagy
+ *
+ * MIT License
+ *
+ * Copyright (c) [2016] Lesleis Nagy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+
+#include <cmath>
+#include <utility>
+#include <vector>
+
+#include <vtkSMPTools.h>
+
+#include "FFT.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// Function next_pow2()                                                      //
+///////////////////////////////////////////////////////////////////////////////
+
+size_t next_pow2(size_t n)
+{
+  size_t p = 1;
+  while (p < n) {
+    p <<= 1;
+  }
+  return p;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Function fft()                                                            //
+///////////////////////////////////////////////////////////////////////////////
+
+void fft(std::complex<double> * data, size_t n, bool inverse)
+{
+  // Bit reversal permutation.
+  for (size_t i = 1, j = 0; i < n; ++i) {
+    size_t bit = n >> 1;
+    for (; j & bit; bit >>= 1) {
+      j ^= bit;
+    }
+    j ^= bit;
+    if (i < j) {
+      std::swap(data[i], data[j]);
+    }
+  }
+
+  // Butterflies.
+  double sign = inverse ? 1.0 : -1.0;
+  for (size_t len = 2; len <= n; len <<= 1) {
+    std::complex<double> wlen = std::polar(1.0, sign*2.0*M_PI/len);
+    for (size_t i = 0; i < n; i += len) {
+      std::complex<double> w(1.0, 0.0);
+      for (size_t k = 0; k < len/2; ++k) {
+        std::complex<double> u = data[i + k];
+        std::complex<double> v = data[i + k + len/2]*w;
+        data[i + k]         = u + v;
+        data[i + k + len/2] = u - v;
+        w *= wlen;
+      }
+    }
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Function fft3d()                                                          //
+///////////////////////////////////////////////////////////////////////////////
+
+void fft3d(std::complex<double> * data, const size_t dims[3], bool inverse)
+{
+  size_t size = dims[0]*dims[1]*dims[2];
+  size_t strides[3] = {1, dims[0], dims[0]*dims[1]};
+
+  for (int d = 0; d < 3; ++d) {
+    size_t n = dims[d];
+    if (n == 1) {
+      continue;
+    }
+
+    // Lines along axis d are indexed by the other two axes (a, b).
+    int    da = (d == 0) ? 1 : 0;
+    int    db = (d == 2) ? 1 : 2;
+    size_t nlines = size/n;
+
+    vtkSMPTools::For(0, nlines, [&](vtkIdType begin, vtkIdType end) {
+      std::vector< std::complex<double> > line(n);
+      for (vtkIdType l = begin; l < end; ++l) {
+        size_t a = l % dims[da];
+        size_t b = l / dims[da];
+        std::complex<double> * p = data + a*strides[da] + b*strides[db];
+
+        for (size_t i = 0; i < n; ++i) {
+          line[i] = p[i*strides[d]];
+        }
+        fft(line.data(), n, inverse);
+        for (size_t i = 0; i < n; ++i) {
+          p[i*strides[d]] = line[i];
+        }
+      }
+    });
+  }
+
+  if (inverse) {
+    double scale = 1.0/size;
+    vtkSMPTools::For(0, size, [&](vtkIdType begin, vtkIdType end) {
+      for (vtkIdType i = begin; i < end; ++i) {
+        data[i] *= scale;
+      }
+    });
+  }
+}
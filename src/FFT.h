@@ -0,0 +1,59 @@
+/**
+ * \file   FFT.h
+ * \author L. Nagy
+ *
+ * MIT License
+ *
+ * Copyright (c) [2016] Lesleis Nagy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+
+#ifndef FFT_H_
+#define FFT_H_
+
+#include <complex>
+#include <cstddef>
+
+/**
+ * Return the smallest power of two >= n.
+ */
+size_t next_pow2(size_t n);
+
+/**
+ * \brief In place radix-2 FFT of a contiguous sequence.
+ *
+ * \param[in,out] data    the sequence.
+ * \param[in]     n       the length of the sequence (a power of two).
+ * \param[in]     inverse if true compute the (unscaled) inverse transform.
+ */
+void fft(std::complex<double> * data, size_t n, bool inverse);
+
+/**
+ * \brief In place 3D FFT of an array with x varying fastest, the 1D
+ *        transforms along each axis are done in parallel over lines.
+ *
+ * \param[in,out] data    the array (dims[0]*dims[1]*dims[2] values).
+ * \param[in]     dims    the dimensions (each a power of two).
+ * \param[in]     inverse if true compute the inverse transform, scaled so
+ *                        that it inverts the forward transform.
+ */
+void fft3d(std::complex<double> * data, const size_t dims[3], bool inverse);
+
+#endif  // FFT_H_
@@ -0,0 +1,252 @@
+/**
+ * \file   FieldStatistics.cpp
+ * \author L. Nagy
+ *
+ * MIT License
+ *
+ * Copyright (c) [2016] Lesleis Nagy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "FieldStatistics.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// QuantileSketch                                                            //
+///////////////////////////////////////////////////////////////////////////////
+
+QuantileSketch::QuantileSketch(double relativeAccuracy, size_t maxBins) :
+  mGamma((1.0 + relativeAccuracy)/(1.0 - relativeAccuracy)),
+  mLogGamma(log(mGamma)),
+  mMaxBins(maxBins),
+  mZeros(0)
+{}
+
+void QuantileSketch::add(double x)
+{
+  if (std::isnan(x)) {
+    return;
+  }
+
+  double magnitude = fabs(x);
+  if (magnitude < std::numeric_limits<double>::min()) {
+    mZeros++;
+  } else if (x > 0.0) {
+    mPositive.add(index(magnitude), 1, mMaxBins);
+  } else {
+    mNegative.add(index(magnitude), 1, mMaxBins);
+  }
+}
+
+void QuantileSketch::merge(const QuantileSketch & other)
+{
+  mZeros += other.mZeros;
+  mPositive.merge(other.mPositive, mMaxBins);
+  mNegative.merge(other.mNegative, mMaxBins);
+}
+
+double QuantileSketch::quantile(double q) const
+{
+  size_t n = count();
+  if (n == 0) {
+    return std::numeric_limits<double>::quiet_NaN();
+  }
+
+  q = std::clamp(q, 0.0, 1.0);
+  size_t rank = (size_t)(q*(n - 1));
+
+  // Negative values, largest magnitude first.
+  size_t seen = 0;
+  for (size_t i = mNegative.counts.size(); i-- > 0; ) {
+    seen += mNegative.counts[i];
+    if (seen > rank) {
+      return -value(mNegative.offset + (int)i);
+    }
+  }
+
+  seen += mZeros;
+  if (seen > rank) {
+    return 0.0;
+  }
+
+  for (size_t i = 0; i < mPositive.counts.size(); ++i) {
+    seen += mPositive.counts[i];
+    if (seen > rank) {
+      return value(mPositive.offset + (int)i);
+    }
+  }
+
+  return value(mPositive.offset + (int)mPositive.counts.size() - 1);
+}
+
+size_t QuantileSketch::memoryBytes() const
+{
+  return (mPositive.counts.capacity() + mNegative.counts.capacity())*sizeof(size_t);
+}
+
+int QuantileSketch::index(double magnitude) const
+{
+  return (int)ceil(log(magnitude)/mLogGamma);
+}
+
+double QuantileSketch::value(int index) const
+{
+  // The midpoint (in relative terms) of (gamma^(i-1), gamma^i].
+  return 2.0*pow(mGamma, index)/(mGamma + 1.0);
+}
+
+void QuantileSketch::Store::add(int index, size_t n, size_t maxBins)
+{
+  if (counts.empty()) {
+    counts.assign(1, 0);
+    offset = index;
+  } else if (index < offset) {
+    counts.insert(counts.begin(), offset - index, 0);
+    offset = index;
+  } else if (index >= offset + (int)counts.size()) {
+    counts.resize(index - offset + 1, 0);
+  }
+
+  counts[index - offset] += n;
+  total += n;
+
+  if (counts.size() > maxBins) {
+    collapse(maxBins);
+  }
+}
+
+void QuantileSketch::Store::merge(const Store & other, size_t maxBins)
+{
+  for (size_t i = 0; i < other.counts.size(); ++i) {
+    if (other.counts[i] > 0) {
+      add(other.offset + (int)i, other.counts[i], maxBins);
+    }
+  }
+}
+
+void QuantileSketch::Store::collapse(size_t maxBins)
+{
+  // Fold the lowest (smallest magnitude) buckets in to the lowest kept one.
+  size_t excess = counts.size() - maxBins;
+  size_t folded = 0;
+  for (size_t i = 0; i <= excess; ++i) {
+    folded += counts[i];
+  }
+  counts.erase(counts.begin(), counts.begin() + excess);
+  counts[0] = folded;
+  offset += (int)excess;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Histogram                                                                 //
+///////////////////////////////////////////////////////////////////////////////
+
+Histogram::Histogram(double lo, double hi, size_t nbins) :
+  mLo(lo), mHi(hi), mCounts(nbins, 0)
+{}
+
+void Histogram::add(double x)
+{
+  if (std::isnan(x)) {
+    return;
+  }
+
+  double s = (x - mLo)/(mHi - mLo)*mCounts.size();
+  size_t bin = (s <= 0.0) ? 0 : std::min((size_t)s, mCounts.size() - 1);
+  mCounts[bin]++;
+}
+
+void Histogram::merge(const Histogram & other)
+{
+  for (size_t i = 0; i < mCounts.size(); ++i) {
+    mCounts[i] += other.mCounts[i];
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// FieldStatistics                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+FieldStatistics::FieldStatistics() :
+  mCount(0),
+  mSum{0.0, 0.0, 0.0},
+  mSumMagnitude(0.0),
+  mHmin( std::numeric_limits<double>::max()),
+  mHmax(-std::numeric_limits<double>::max()),
+  mHsum(0.0)
+{}
+
+void FieldStatistics::add(const double m[3], double h)
+{
+  double magnitude = sqrt(m[0]*m[0] + m[1]*m[1] + m[2]*m[2]);
+
+  mCount++;
+  mSum[0] += m[0];
+  mSum[1] += m[1];
+  mSum[2] += m[2];
+  mSumMagnitude += magnitude;
+
+  mHmin = std::min(mHmin, h);
+  mHmax = std::max(mHmax, h);
+  mHsum += h;
+  mHelicity.add(h);
+
+  if (magnitude > 0.0) {
+    for (int d = 0; d < 3; ++d) {
+      mCosines[d].add(m[d]/magnitude);
+    }
+  }
+}
+
+void FieldStatistics::merge(const FieldStatistics & other)
+{
+  mCount += other.mCount;
+  for (int d = 0; d < 3; ++d) {
+    mSum[d] += other.mSum[d];
+    mCosines[d].merge(other.mCosines[d]);
+  }
+  mSumMagnitude += other.mSumMagnitude;
+
+  mHmin = std::min(mHmin, other.mHmin);
+  mHmax = std::max(mHmax, other.mHmax);
+  mHsum += other.mHsum;
+  mHelicity.merge(other.mHelicity);
+}
+
+Vector3d FieldStatistics::mean() const
+{
+  if (mCount == 0) {
+    return {.x = 0.0, .y = 0.0, .z = 0.0};
+  }
+  return {.x = mSum[0]/mCount, .y = mSum[1]/mCount, .z = mSum[2]/mCount};
+}
+
+double FieldStatistics::meanMagnitude() const
+{
+  return mCount == 0 ? 0.0 : mSumMagnitude/mCount;
+}
+
+double FieldStatistics::hmean() const
+{
+  return mCount == 0 ? 0.0 : mHsum/mCount;
+}
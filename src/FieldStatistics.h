@@ -0,0 +1,167 @@
+/**
+ * \file   FieldStatistics.h
+ * \author L. Nagy
+ *
+ * MIT License
+ *
+ * Copyright (c) [2016] Lesleis Nagy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+
+#ifndef FIELD_STATISTICS_H_
+#define FIELD_STATISTICS_H_
+
+#include <vector>
+
+#include "Data.h"
+
+/**
+ * \brief A mergeable streaming quantile sketch with bounded relative error.
+ *
+ * Values are counted in logarithmically spaced buckets (bucket i holds
+ * magnitudes in (gamma^(i-1), gamma^i] with gamma = (1+a)/(1-a)), so any
+ * quantile is returned with a relative error of at most a. Positive and
+ * negative values are counted separately. Sketches built on disjoint parts
+ * of the data merge exactly, so they are suitable for parallel reductions.
+ * If the number of buckets exceeds a limit the buckets of smallest
+ * magnitude are collapsed together.
+ */
+class QuantileSketch
+{
+public:
+  explicit QuantileSketch(double relativeAccuracy = 0.01, size_t maxBins = 2048);
+
+  void add(double x);
+
+  void merge(const QuantileSketch & other);
+
+  /**
+   * \brief Return the (approximate) q-quantile, q in [0, 1].
+   */
+  double quantile(double q) const;
+
+  size_t count() const { return mZeros + mPositive.total + mNegative.total; }
+
+  size_t memoryBytes() const;
+
+private:
+  /// Dense counts of contiguous bucket indices.
+  struct Store {
+    std::vector<size_t> counts;
+    int                 offset = 0;
+    size_t              total  = 0;
+
+    void add(int index, size_t n, size_t maxBins);
+    void merge(const Store & other, size_t maxBins);
+    void collapse(size_t maxBins);
+  };
+
+  double mGamma;
+  double mLogGamma;
+  size_t mMaxBins;
+  size_t mZeros;
+  Store  mPositive;
+  Store  mNegative;
+
+  int    index(double magnitude) const;
+  double value(int index) const;
+};
+
+/**
+ * \brief A mergeable histogram with fixed, equal width bins over [lo, hi],
+ *        values outside the range are counted in the end bins.
+ */
+class Histogram
+{
+public:
+  explicit Histogram(double lo = -1.0, double hi = 1.0, size_t nbins = 64);
+
+  void add(double x);
+
+  void merge(const Histogram & other);
+
+  double lo() const { return mLo; }
+
+  double hi() const { return mHi; }
+
+  double binWidth() const { return (mHi - mLo)/mCounts.size(); }
+
+  const std::vector<size_t> & counts() const { return mCounts; }
+
+private:
+  double              mLo;
+  double              mHi;
+  std::vector<size_t> mCounts;
+};
+
+/**
+ * \brief Statistics of a (nodal) magnetisation field and its helicity.
+ *
+ * Everything is accumulated by add() in a single pass over the vertices and
+ * partial statistics merge, so a model's statistics are one parallel
+ * reduction.
+ */
+class FieldStatistics
+{
+public:
+  FieldStatistics();
+
+  /**
+   * \brief Accumulate one vertex.
+   *
+   * \param[in] m the magnetisation at the vertex.
+   * \param[in] h the helicity at the vertex.
+   */
+  void add(const double m[3], double h);
+
+  void merge(const FieldStatistics & other);
+
+  size_t count() const { return mCount; }
+
+  /// The mean magnetisation.
+  Vector3d mean() const;
+
+  /// The mean of the magnetisation magnitude.
+  double meanMagnitude() const;
+
+  double hmin() const { return mHmin; }
+
+  double hmax() const { return mHmax; }
+
+  double hmean() const;
+
+  /// The (approximate) q-quantile of the helicity.
+  double helicityQuantile(double q) const { return mHelicity.quantile(q); }
+
+  /// The histogram of the direction cosine of m with axis d (0, 1 or 2).
+  const Histogram & directionCosines(int d) const { return mCosines[d]; }
+
+private:
+  size_t         mCount;
+  double         mSum[3];
+  double         mSumMagnitude;
+  double         mHmin;
+  double         mHmax;
+  double         mHsum;
+  QuantileSketch mHelicity;
+  Histogram      mCosines[3];
+};
+
+#endif  // FIELD_STATISTICS_H_
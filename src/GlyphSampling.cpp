@@ -0,0 +1,231 @@
+/**
+ * \file   GlyphSampling.cpp
+ * \author L. Nagy
+ *
+ * MIT License
+ *
+ * Copyright (c) [2016] Lesleis Nagy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+
+#include <vtkSMPTools.h>
+
+#include "GlyphSampling.h"
+
+/// The number of bits of each voxel coordinate in a voxel key.
+static const int    sVoxelBits = 20;
+
+/// The largest number of voxelisation passes.
+static const int    sMaxPasses = 16;
+
+/// The relative tolerance on the number of picked vertices.
+static const double sTolerance = 0.05;
+
+/**
+ * A vertex in a voxel, ordered by voxel and then by distance from the voxel
+ * centre.
+ */
+struct VoxelSample {
+  uint64_t  key;
+  double    dist;
+  vtkIdType id;
+
+  bool operator< (const VoxelSample & other) const
+  {
+    return key < other.key || (key == other.key && dist < other.dist);
+  }
+};
+
+/**
+ * Voxelise the candidate vertices with voxels of size h (h/2 for candidates
+ * at level one) and sort them, returning the number of occupied voxels.
+ */
+static size_t voxelise(
+    const VertexField3d            & vert,
+    const vtkIdType                * subset,
+    const double                     lo[3],
+    double                           h,
+    const std::vector<uint8_t>     & levels,
+    std::vector<VoxelSample>       & samples)
+{
+  const uint64_t maxVoxel = (1ULL << sVoxelBits) - 1;
+
+  vtkSMPTools::For(0, samples.size(), [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType j = begin; j < end; ++j) {
+      vtkIdType i     = subset != NULL ? subset[j] : j;
+      uint64_t  level = levels.empty() ? 0 : levels[j];
+      double    hl    = level > 0 ? h/2.0 : h;
+      double    x[3]  = {vert[i].x, vert[i].y, vert[i].z};
+
+      uint64_t key  = level << (3*sVoxelBits);
+      double   dist = 0.0;
+      for (int d = 0; d < 3; ++d) {
+        double   s = (x[d] - lo[d])/hl;
+        uint64_t v = std::min((uint64_t)std::max(s, 0.0), maxVoxel);
+        double   c = ((double)v + 0.5) - s;
+        key  |= v << ((2 - d)*sVoxelBits);
+        dist += c*c;
+      }
+      samples[j] = {key, dist, i};
+    }
+  });
+
+  vtkSMPTools::Sort(samples.begin(), samples.end());
+
+  size_t nvoxel = 0;
+  for (size_t j = 0; j < samples.size(); ++j) {
+    if (j == 0 || samples[j].key != samples[j-1].key) {
+      ++nvoxel;
+    }
+  }
+
+  return nvoxel;
+}
+
+void glyph_sample(
+    const VertexField3d    & vert,
+    size_t                   target,
+    const double           * weight,
+    std::vector<vtkIdType> & ids)
+{
+  glyph_sample(vert, NULL, vert.size(), target, weight, ids);
+}
+
+void glyph_sample(
+    const VertexField3d    & vert,
+    const vtkIdType        * subset,
+    size_t                   nsubset,
+    size_t                   target,
+    const double           * weight,
+    std::vector<vtkIdType> & ids)
+{
+  if (target >= nsubset || target == 0) {
+    if (subset != NULL) {
+      ids.assign(subset, subset + nsubset);
+    } else {
+      ids.resize(nsubset);
+      std::iota(ids.begin(), ids.end(), 0);
+    }
+    return;
+  }
+
+  // Bounds of the candidates.
+  double lo[3] = { 1E300,  1E300,  1E300};
+  double hi[3] = {-1E300, -1E300, -1E300};
+  for (size_t j = 0; j < nsubset; ++j) {
+    const Vertex3d & v = vert[subset != NULL ? subset[j] : j];
+    lo[0] = std::min(lo[0], v.x); hi[0] = std::max(hi[0], v.x);
+    lo[1] = std::min(lo[1], v.y); hi[1] = std::max(hi[1], v.y);
+    lo[2] = std::min(lo[2], v.z); hi[2] = std::max(hi[2], v.z);
+  }
+  double extent = std::max({hi[0] - lo[0], hi[1] - lo[1], hi[2] - lo[2]});
+  if (extent <= 0.0) {
+    ids.assign(1, subset != NULL ? subset[0] : 0);
+    return;
+  }
+
+  // Candidates with the largest weights are sampled more densely.
+  std::vector<uint8_t> levels;
+  if (weight != NULL) {
+    std::vector<double> sorted(nsubset);
+    for (size_t j = 0; j < nsubset; ++j) {
+      sorted[j] = weight[subset != NULL ? subset[j] : j];
+    }
+    std::nth_element(sorted.begin(), sorted.begin() + 3*nsubset/4, sorted.end());
+    double threshold = sorted[3*nsubset/4];
+
+    levels.resize(nsubset);
+    vtkSMPTools::For(0, nsubset, [&](vtkIdType begin, vtkIdType end) {
+      for (vtkIdType j = begin; j < end; ++j) {
+        levels[j] = weight[subset != NULL ? subset[j] : j] >= threshold ? 1 : 0;
+      }
+    });
+  }
+
+  // Search for the voxel size (in log space, bracketing the target count).
+  double hmin = extent/(double)(1 << sVoxelBits);
+  double volume = 1.0;
+  int    ndim   = 0;
+  for (int d = 0; d < 3; ++d) {
+    if (hi[d] - lo[d] > 1E-6*extent) {
+      volume *= hi[d] - lo[d];
+      ++ndim;
+    }
+  }
+  double h = std::max(pow(volume/(double)target, 1.0/ndim), hmin);
+
+  std::vector<VoxelSample> samples(nsubset);
+
+  double bestH     = h;
+  double bestError = 1E300;
+  double hLo = 0.0, cLo = 0.0;
+  double hHi = 0.0, cHi = 0.0;
+  double lastH     = h;
+  for (int pass = 0; pass < sMaxPasses; ++pass) {
+    lastH = h;
+    size_t count = voxelise(vert, subset, lo, h, levels, samples);
+    double error = fabs((double)count - (double)target)/(double)target;
+    if (error < bestError) {
+      bestError = error;
+      bestH     = h;
+    }
+    if (error <= sTolerance) {
+      break;
+    }
+
+    // Smaller voxels give more vertices.
+    if (count > target) {
+      hLo = h; cLo = (double)count;
+    } else {
+      hHi = h; cHi = (double)count;
+      if (h <= hmin) {
+        break;
+      }
+    }
+
+    if (hLo > 0.0 && hHi > 0.0) {
+      // Interpolate log(count) against log(h) between the brackets.
+      double t = (log(cLo) - log((double)target))/(log(cLo) - log(cHi));
+      t = std::min(std::max(t, 0.1), 0.9);
+      h = exp(log(hLo) + t*(log(hHi) - log(hLo)));
+    } else {
+      h = h*pow((double)count/(double)target, 1.0/ndim);
+    }
+    h = std::max(h, hmin);
+  }
+
+  if (bestH != lastH) {
+    voxelise(vert, subset, lo, bestH, levels, samples);
+  }
+
+  // The first (closest to the centre) vertex in each voxel.
+  ids.clear();
+  for (size_t j = 0; j < samples.size(); ++j) {
+    if (j == 0 || samples[j].key != samples[j-1].key) {
+      ids.push_back(samples[j].id);
+    }
+  }
+  vtkSMPTools::Sort(ids.begin(), ids.end());
+}
@@ -0,0 +1,77 @@
+/**
+ * \file   GlyphSampling.h
+ * \author L. Nagy
+ *
+ * MIT License
+ *
+ * Copyright (c) [2016] Lesleis Nagy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+
+#ifndef GLYPH_SAMPLING_H_
+#define GLYPH_SAMPLING_H_
+
+#include <vector>
+
+#include <vtkType.h>
+
+#include "Data.h"
+
+/**
+ * \brief Pick a spatially uniform subset of (about) target vertices, e.g.
+ *        at which to draw glyphs.
+ *
+ * Space is divided in to cubic voxels and the vertex closest to the centre
+ * of each occupied voxel is picked. The voxel size is adjusted, with a few
+ * parallel passes, until the number of occupied voxels is within 5% of the
+ * target. If weights are given, the quarter of the vertices with the
+ * largest weights are sampled on voxels of half the size, i.e. at up to
+ * eight times the density; weighting by |grad m| places more glyphs where
+ * the field varies quickly.
+ *
+ * \param[in]  vert   the vertices.
+ * \param[in]  target the number of vertices to pick, every vertex is
+ *                    picked if this is not less than the number of
+ *                    vertices.
+ * \param[in]  weight per vertex weights, or NULL for a uniform subset.
+ * \param[out] ids    the picked vertices, in increasing order.
+ */
+void glyph_sample(
+    const VertexField3d    & vert,
+    size_t                   target,
+    const double           * weight,
+    std::vector<vtkIdType> & ids);
+
+/**
+ * \brief As above, but only pick from the given (candidate) vertices, e.g.
+ *        those on the boundary surface.
+ *
+ * \param[in] subset  the candidate vertices, NULL for every vertex.
+ * \param[in] nsubset the number of candidate vertices.
+ */
+void glyph_sample(
+    const VertexField3d    & vert,
+    const vtkIdType        * subset,
+    size_t                   nsubset,
+    size_t                   target,
+    const double           * weight,
+    std::vector<vtkIdType> & ids);
+
+#endif  // GLYPH_SAMPLING_H_
@@ -0,0 +1,226 @@
+/**
+ * \file   GridResampler.cpp
+ * \author L. Nagy
+ *
+ * MIT License
+ *
+ * Copyright (c) [2016] Lesleis Nagy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+
+#include <vtkSMPTools.h>
+
+#include "GridResampler.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// UniformGrid                                                               //
+///////////////////////////////////////////////////////////////////////////////
+
+UniformGrid UniformGrid::fit(const BoundingBox & box, size_t maxDim)
+{
+  UniformGrid grid;
+
+  double extent[3];
+  double maxExtent = 0.0;
+  for (int d = 0; d < 3; ++d) {
+    extent[d] = std::max(box.hi[d] - box.lo[d], 0.0);
+    maxExtent = std::max(maxExtent, extent[d]);
+  }
+
+  double h = (maxDim > 1 && maxExtent > 0.0) ? maxExtent/(maxDim - 1) : 1.0;
+  for (int d = 0; d < 3; ++d) {
+    grid.origin[d]  = box.lo[d];
+    grid.spacing[d] = h;
+    grid.dims[d]    = (size_t)floor(extent[d]/h + 1E-9) + 1;
+  }
+
+  return grid;
+}
+
+bool operator == (const UniformGrid & lhs, const UniformGrid & rhs)
+{
+  for (int d = 0; d < 3; ++d) {
+    if (lhs.origin[d]  != rhs.origin[d]  ||
+        lhs.spacing[d] != rhs.spacing[d] ||
+        lhs.dims[d]    != rhs.dims[d]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Constructor                                                               //
+///////////////////////////////////////////////////////////////////////////////
+
+GridResampler::GridResampler(
+    const VertexField3d   & vert,
+    const ConnectIndices4 & conn,
+    const UniformGrid     & grid) :
+  mGrid(grid)
+{
+  const vtkIdType none = std::numeric_limits<vtkIdType>::max();
+  const double    tol  = -1E-10;
+
+  size_t nnodes = mGrid.size();
+
+  std::vector< std::atomic<vtkIdType> > owner(nnodes);
+  vtkSMPTools::For(0, nnodes, [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType n = begin; n < end; ++n) {
+      owner[n].store(none, std::memory_order_relaxed);
+    }
+  });
+
+  // Rasterise each tetrahedron's bounding box, claiming the grid nodes that
+  // are inside the tetrahedron.
+  vtkSMPTools::For(0, conn.size(), [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType t = begin; t < end; ++t) {
+      const Connect4 & c = conn[t];
+
+      size_t lo[3], hi[3];
+      bool   empty = false;
+      for (int d = 0; d < 3; ++d) {
+        double vmin = std::numeric_limits<double>::max();
+        double vmax = -vmin;
+        for (int k = 0; k < 4; ++k) {
+          const Vertex3d & v = vert[c[k]];
+          double x = (d == 0) ? v.x : ((d == 1) ? v.y : v.z);
+          vmin = std::min(vmin, x);
+          vmax = std::max(vmax, x);
+        }
+
+        double a = ceil ((vmin - mGrid.origin[d])/mGrid.spacing[d] - 1E-9);
+        double b = floor((vmax - mGrid.origin[d])/mGrid.spacing[d] + 1E-9);
+        a = std::max(a, 0.0);
+        b = std::min(b, (double)mGrid.dims[d] - 1.0);
+        if (a > b) {
+          empty = true;
+          break;
+        }
+        lo[d] = (size_t)a;
+        hi[d] = (size_t)b;
+      }
+      if (empty) {
+        continue;
+      }
+
+      for (size_t k = lo[2]; k <= hi[2]; ++k) {
+        for (size_t j = lo[1]; j <= hi[1]; ++j) {
+          for (size_t i = lo[0]; i <= hi[0]; ++i) {
+            double bary[4];
+            if (!barycentric(vert[c[0]], vert[c[1]], vert[c[2]], vert[c[3]],
+                             mGrid.node(i, j, k), bary)) {
+              continue;
+            }
+            if (bary[0] < tol || bary[1] < tol || bary[2] < tol || bary[3] < tol) {
+              continue;
+            }
+
+            std::atomic<vtkIdType> & o = owner[mGrid.index(i, j, k)];
+            vtkIdType current = o.load(std::memory_order_relaxed);
+            while (t < current &&
+                   !o.compare_exchange_weak(current, t, std::memory_order_relaxed)) {
+            }
+          }
+        }
+      }
+    }
+  });
+
+  // Compact the nodes that are inside the mesh in to rows.
+  for (size_t n = 0; n < nnodes; ++n) {
+    if (owner[n].load(std::memory_order_relaxed) != none) {
+      mRows.push_back(n);
+    }
+  }
+
+  // Interpolation weights for each row, from the owning tetrahedron.
+  mCols.resize(mRows.size());
+  mWeights.resize(mRows.size());
+  vtkSMPTools::For(0, mRows.size(), [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType r = begin; r < end; ++r) {
+      size_t n = mRows[r];
+      size_t i = n % mGrid.dims[0];
+      size_t j = (n/mGrid.dims[0]) % mGrid.dims[1];
+      size_t k = n/(mGrid.dims[0]*mGrid.dims[1]);
+
+      const Connect4 & c = conn[owner[n].load(std::memory_order_relaxed)];
+
+      double bary[4];
+      barycentric(vert[c[0]], vert[c[1]], vert[c[2]], vert[c[3]],
+                  mGrid.node(i, j, k), bary);
+
+      mCols[r] = c;
+      for (int l = 0; l < 4; ++l) {
+        mWeights[r][l] = bary[l];
+      }
+    }
+  });
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Function apply()                                                          //
+///////////////////////////////////////////////////////////////////////////////
+
+void GridResampler::apply(
+    const double * field,
+    size_t         ncomp,
+    double       * out,
+    double         outside) const
+{
+  std::fill(out, out + mGrid.size()*ncomp, outside);
+
+  vtkSMPTools::For(0, mRows.size(), [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType r = begin; r < end; ++r) {
+      double           * o = out + mRows[r]*ncomp;
+      const Connect4   & c = mCols[r];
+      const double     * w = mWeights[r].data();
+      for (size_t d = 0; d < ncomp; ++d) {
+        o[d] = w[0]*field[c[0]*ncomp + d] + w[1]*field[c[1]*ncomp + d]
+             + w[2]*field[c[2]*ncomp + d] + w[3]*field[c[3]*ncomp + d];
+      }
+    }
+  });
+}
+
+void GridResampler::resample(const double * field, VectorField3d & out) const
+{
+  out.resize(mGrid.size());
+  if (out.empty()) {
+    return;
+  }
+  apply(field, 3, &out[0].x);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Function memoryBytes()                                                    //
+///////////////////////////////////////////////////////////////////////////////
+
+size_t GridResampler::memoryBytes() const
+{
+  return mRows.capacity()*sizeof(size_t)
+       + mCols.capacity()*sizeof(Connect4)
+       + mWeights.capacity()*sizeof(std::array<double, 4>);
+}
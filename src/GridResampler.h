@@ -0,0 +1,132 @@
+/**
+ * \file   GridResampler.h
+ * \author L. Nagy
+ *
+ * MIT License
+ *
+ * Copyright (c) [2016] Lesleis Nagy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+
+
+#ifndef GRID_RESAMPLER_H_
+#define GRID_RESAMPLER_H_
+
+#include <array>
+#include <vector>
+
+#include "Data.h"
+#include "TetBVH.h"
+
+/**
+ * \brief A uniform (regular) grid of nodes.
+ */
+struct UniformGrid {
+  /// The position of node (0, 0, 0).
+  double origin[3];
+  /// The spacing between nodes along each axis.
+  double spacing[3];
+  /// The number of nodes along each axis.
+  size_t dims[3];
+
+  /// The total number of nodes.
+  size_t size() const { return dims[0]*dims[1]*dims[2]; }
+
+  /// The linear index of node (i, j, k), x varies fastest.
+  size_t index(size_t i, size_t j, size_t k) const {
+    return (k*dims[1] + j)*dims[0] + i;
+  }
+
+  /// The position of node (i, j, k).
+  Vertex3d node(size_t i, size_t j, size_t k) const {
+    return {.x = origin[0] + i*spacing[0],
+            .y = origin[1] + j*spacing[1],
+            .z = origin[2] + k*spacing[2]};
+  }
+
+  /**
+   * \brief Create an isotropic grid covering a bounding box with (at most)
+   *        maxDim nodes along its longest side.
+   */
+  static UniformGrid fit(const BoundingBox & box, size_t maxDim);
+};
+bool operator == (const UniformGrid & lhs, const UniformGrid & rhs);
+
+/**
+ * \brief Resampling of nodal (P1) fields on a tetrahedral mesh on to a
+ *        uniform grid.
+ *
+ * The interpolation weights are computed once and stored as a sparse matrix
+ * with four entries (the barycentric coordinates) for every grid node inside
+ * the mesh, so that resampling any field on the mesh is a sparse mat-vec.
+ * Resamplers are cached per mesh, see TetMesh::resampler().
+ */
+class GridResampler
+{
+public:
+  /**
+   * \brief Compute interpolation weights, each tetrahedron's bounding box is
+   *        rasterised in to the grid in parallel. A grid node on a shared
+   *        face is claimed by the lowest numbered tetrahedron containing it
+   *        (a lock free atomic minimum) so the result is deterministic.
+   */
+  GridResampler(
+      const VertexField3d   & vert,
+      const ConnectIndices4 & conn,
+      const UniformGrid     & grid);
+
+  const UniformGrid & grid() const { return mGrid; }
+
+  /// The number of grid nodes that are inside the mesh.
+  size_t ninside() const { return mRows.size(); }
+
+  /// The indices of the grid nodes that are inside the mesh.
+  const std::vector<size_t> & insideNodes() const { return mRows; }
+
+  /**
+   * \brief Resample a nodal field with ncomp components (interleaved).
+   *
+   * \param[in]  field   the nodal field on the mesh.
+   * \param[in]  ncomp   the number of components of the field.
+   * \param[out] out     the resampled field, grid().size()*ncomp values.
+   * \param[in]  outside the value given to nodes outside the mesh.
+   */
+  void apply(
+      const double * field,
+      size_t         ncomp,
+      double       * out,
+      double         outside = 0.0) const;
+
+  /**
+   * \brief Resample a vector field, nodes outside the mesh are zero.
+   */
+  void resample(const double * field, VectorField3d & out) const;
+
+  /// The approximate memory used by the interpolation weights.
+  size_t memoryBytes() const;
+
+private:
+  UniformGrid                           mGrid;
+  std::vector<size_t>                   mRows;
+  std::vector<Connect4>                 mCols;
+  std::vector< std::array<double, 4> >  mWeights;
+};
+
+#endif  // GRID_RESAMPLER_H_
@@ -0,0 +1,305 @@
+/**
+ * \file   MarchingTets.cpp
+ * \author L. Nagy
+ *
+ * MIT License
+ *
+ * Copyright (c) [2016] Lesleis Nagy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+
+#include <algorithm>
+#include <array>
+#include <utility>
+
+#include <vtkCellArray.h>
+#include <vtkDoubleArray.h>
+#include <vtkIdTypeArray.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkSMPThreadLocal.h>
+#include <vtkSMPTools.h>
+
+#include "DebugMacros.h"
+#include "MarchingTets.h"
+
+/**
+ * A vertex of an isosurface, i.e. the crossing of an isovalue on a mesh edge.
+ */
+struct IsoVertex {
+  /// The canonical key of the edge.
+  Connect2::Key edge;
+  /// The index of the isovalue.
+  uint32_t      value;
+};
+inline bool operator == (const IsoVertex & lhs, const IsoVertex & rhs) {
+  return lhs.edge == rhs.edge && lhs.value == rhs.value;
+}
+inline bool operator < (const IsoVertex & lhs, const IsoVertex & rhs) {
+  return lhs.value < rhs.value || (lhs.value == rhs.value && lhs.edge < rhs.edge);
+}
+
+/**
+ * An isosurface triangle.
+ */
+struct IsoTriangle {
+  IsoVertex v[3];
+};
+
+/**
+ * Triangles found by one thread, with the ranges of tetrahedra (chunks) that
+ * produced them so that the output can be assembled in mesh order.
+ */
+struct IsoBuffer {
+  std::vector<IsoTriangle>               triangles;
+  /// (first tetrahedron index, first triangle, end triangle) of each chunk.
+  std::vector< std::array<vtkIdType, 3> > chunks;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// Functor to find isosurface triangles.                                     //
+///////////////////////////////////////////////////////////////////////////////
+
+struct MarchingTetsFunctor
+{
+  const VertexField3d           & vert;
+  const ConnectIndices4         & conn;
+  const double                  * scalar;
+  const std::vector<double>     & values;
+  const vtkIdType               * tets;
+  vtkSMPThreadLocal<IsoBuffer>    local;
+  std::vector<IsoTriangle>        triangles;
+
+  MarchingTetsFunctor(
+      const VertexField3d       & vert,
+      const ConnectIndices4     & conn,
+      const double              * scalar,
+      const std::vector<double> & values,
+      const vtkIdType           * tets) :
+    vert(vert), conn(conn), scalar(scalar), values(values), tets(tets)
+  {}
+
+  // Thread locals are default constructed (empty) buffers.
+  void Initialize() {}
+
+  /// The point at which 'iso' is crossed on the edge a-b.
+  Vertex3d crossing(uint a, uint b, double iso) const
+  {
+    double t = (iso - scalar[a])/(scalar[b] - scalar[a]);
+    return (1.0 - t)*vert[a] + t*vert[b];
+  }
+
+  /// Emit the triangle (a0-b0, a1-b1, a2-b2), oriented along 'up'.
+  void emit(
+      IsoBuffer      & buffer,
+      const uint       a[3],
+      const uint       b[3],
+      uint32_t         value,
+      const Vector3d & up) const
+  {
+    double iso = values[value];
+    Vertex3d p[3];
+    IsoTriangle tri;
+    for (int k = 0; k < 3; ++k) {
+      p[k] = crossing(a[k], b[k], iso);
+      tri.v[k].edge  = Connect2({{a[k], b[k]}}).key();
+      tri.v[k].value = value;
+    }
+    if (dot(cross(p[1] - p[0], p[2] - p[0]), up) < 0.0) {
+      std::swap(tri.v[1], tri.v[2]);
+    }
+    buffer.triangles.push_back(tri);
+  }
+
+  void operator() (vtkIdType begin, vtkIdType end)
+  {
+    IsoBuffer & buffer = local.Local();
+    vtkIdType first = buffer.triangles.size();
+
+    for (vtkIdType i = begin; i < end; ++i) {
+      const Connect4 & c = conn[tets ? tets[i] : i];
+      double s[4] = {scalar[c[0]], scalar[c[1]], scalar[c[2]], scalar[c[3]]};
+
+      for (uint32_t j = 0; j < values.size(); ++j) {
+        double iso = values[j];
+
+        // Split the vertices in to those above and below the isovalue.
+        uint above[4], below[4];
+        int  nabove = 0, nbelow = 0;
+        for (int k = 0; k < 4; ++k) {
+          if (s[k] >= iso) {
+            above[nabove++] = c[k];
+          } else {
+            below[nbelow++] = c[k];
+          }
+        }
+        if (nabove == 0 || nbelow == 0) {
+          continue;
+        }
+
+        // Triangles face from the vertices below to those above.
+        Vertex3d ca = {.x = 0.0, .y = 0.0, .z = 0.0}, cb = ca;
+        for (int k = 0; k < nabove; ++k) { ca = ca + vert[above[k]]; }
+        for (int k = 0; k < nbelow; ++k) { cb = cb + vert[below[k]]; }
+        Vector3d up = ca/nabove - cb/nbelow;
+
+        if (nabove == 1 || nbelow == 1) {
+          // One vertex is cut off: a triangle.
+          const uint * one  = (nabove == 1) ? above : below;
+          const uint * rest = (nabove == 1) ? below : above;
+          uint a[3] = {one[0], one[0], one[0]};
+          uint b[3] = {rest[0], rest[1], rest[2]};
+          emit(buffer, a, b, j, up);
+        } else {
+          // Two vertices are cut off: a quadrilateral, split in two.
+          uint a0[3] = {above[0], above[0], above[1]};
+          uint b0[3] = {below[0], below[1], below[1]};
+          emit(buffer, a0, b0, j, up);
+          uint a1[3] = {above[0], above[1], above[1]};
+          uint b1[3] = {below[0], below[1], below[0]};
+          emit(buffer, a1, b1, j, up);
+        }
+      }
+    }
+
+    if ((vtkIdType)buffer.triangles.size() > first) {
+      buffer.chunks.push_back({begin, first, (vtkIdType)buffer.triangles.size()});
+    }
+  }
+
+  void Reduce()
+  {
+    // Join the chunks from all threads in mesh order.
+    std::vector< std::pair< std::array<vtkIdType, 3>, const IsoBuffer * > > chunks;
+    for (const IsoBuffer & buffer : local) {
+      for (const std::array<vtkIdType, 3> & chunk : buffer.chunks) {
+        chunks.push_back({chunk, &buffer});
+      }
+    }
+    std::sort(chunks.begin(), chunks.end(),
+        [](const std::pair< std::array<vtkIdType, 3>, const IsoBuffer * > & lhs,
+           const std::pair< std::array<vtkIdType, 3>, const IsoBuffer * > & rhs) {
+          return lhs.first[0] < rhs.first[0];
+        });
+
+    triangles.clear();
+    for (const auto & chunk : chunks) {
+      const std::vector<IsoTriangle> & source = chunk.second->triangles;
+      triangles.insert(triangles.end(),
+                       source.begin() + chunk.first[1],
+                       source.begin() + chunk.first[2]);
+    }
+  }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// Function marching_tets()                                                  //
+///////////////////////////////////////////////////////////////////////////////
+
+vtkSmartPointer<vtkPolyData> marching_tets(
+    const VertexField3d       & vert,
+    const ConnectIndices4     & conn,
+    const double              * scalar,
+    const std::vector<double> & values)
+{
+  return marching_tets(vert, conn, scalar, values, NULL, conn.size());
+}
+
+vtkSmartPointer<vtkPolyData> marching_tets(
+    const VertexField3d       & vert,
+    const ConnectIndices4     & conn,
+    const double              * scalar,
+    const std::vector<double> & values,
+    const vtkIdType           * tets,
+    size_t                      ntets)
+{
+  MarchingTetsFunctor functor(vert, conn, scalar, values, tets);
+  vtkSMPTools::For(0, ntets, functor);
+  const std::vector<IsoTriangle> & triangles = functor.triangles;
+
+  // Weld vertices, i.e. the distinct (isovalue, edge) pairs.
+  vtkIdType ntri = triangles.size();
+  std::vector<IsoVertex> keys(3*ntri);
+  vtkSMPTools::For(0, ntri, [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType t = begin; t < end; ++t) {
+      for (int k = 0; k < 3; ++k) {
+        keys[3*t + k] = triangles[t].v[k];
+      }
+    }
+  });
+  vtkSMPTools::Sort(keys.begin(), keys.end());
+  keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+  vtkIdType npoints = keys.size();
+
+  // Points, interpolated once per distinct vertex.
+  vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+  points->SetDataTypeToDouble();
+  points->SetNumberOfPoints(npoints);
+  double * xyz = vtkDoubleArray::SafeDownCast(points->GetData())->GetPointer(0);
+
+  vtkSmartPointer<vtkDoubleArray> isovalue = vtkSmartPointer<vtkDoubleArray>::New();
+  isovalue->SetName("Isovalue");
+  isovalue->SetNumberOfValues(npoints);
+  double * iso = isovalue->GetPointer(0);
+
+  vtkSMPTools::For(0, npoints, [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType p = begin; p < end; ++p) {
+      uint a = keys[p].edge >> 32, b = keys[p].edge & 0xffffffff;
+      double value = values[keys[p].value];
+      double t     = (value - scalar[a])/(scalar[b] - scalar[a]);
+      Vertex3d x   = (1.0 - t)*vert[a] + t*vert[b];
+      xyz[3*p]     = x.x;
+      xyz[3*p+1]   = x.y;
+      xyz[3*p+2]   = x.z;
+      iso[p]       = value;
+    }
+  });
+
+  // Triangles, in terms of the welded vertices.
+  vtkSmartPointer<vtkIdTypeArray> offsets = vtkSmartPointer<vtkIdTypeArray>::New();
+  offsets->SetNumberOfValues(ntri + 1);
+  vtkSmartPointer<vtkIdTypeArray> connectivity = vtkSmartPointer<vtkIdTypeArray>::New();
+  connectivity->SetNumberOfValues(3*ntri);
+  vtkIdType * o = offsets->GetPointer(0);
+  vtkIdType * c = connectivity->GetPointer(0);
+
+  vtkSMPTools::For(0, ntri, [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType t = begin; t < end; ++t) {
+      o[t] = 3*t;
+      for (int k = 0; k < 3; ++k) {
+        c[3*t + k] = std::lower_bound(keys.begin(), keys.end(), triangles[t].v[k])
+                   - keys.begin();
+      }
+    }
+  });
+  o[ntri] = 3*ntri;
+
+  vtkSmartPointer<vtkCellArray> polys = vtkSmartPointer<vtkCellArray>::New();
+  polys->SetData(offsets, connectivity);
+
+  vtkSmartPointer<vtkPolyData> polyData = vtkSmartPointer<vtkPolyData>::New();
+  polyData->SetPoints(points);
+  polyData->SetPolys(polys);
+  polyData->GetPointData()->SetScalars(isovalue);
+
+  DEBUG("Isosurface: " << ntri << " triangles, " << npoints << " points");
+
+  return polyData;
+}
@@ -0,0 +1,80 @@
+/**
+ * \file   MarchingTets.h
+ * \author L. Nagy
+ *
+ * MIT License
+ *
+ * Copyright (c) [2016] Lesleis Nagy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+
+#ifndef MARCHING_TETS_H_
+#define MARCHING_TETS_H_
+
+#include <vector>
+
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+
+#include "Data.h"
+
+/**
+ * \brief Contour a nodal scalar field on a tetrahedral mesh.
+ *
+ * Tetrahedra are processed in parallel, each thread writes the triangles it
+ * finds (as the mesh edges on which their vertices lie) to its own buffer
+ * and the buffers are joined in mesh order. Triangle vertices are then
+ * welded by sorting the canonical keys of their edges, so the surface is
+ * connected and each vertex is interpolated once. All isovalues are
+ * contoured in the same pass over the mesh.
+ *
+ * Triangles are oriented so that their normals point towards increasing
+ * values. The output has a point array "Isovalue" (the active scalars)
+ * holding the isovalue each vertex belongs to.
+ *
+ * \param[in] vert   the mesh vertices.
+ * \param[in] conn   the mesh tetrahedra.
+ * \param[in] scalar the scalar field (one value per vertex).
+ * \param[in] values the isovalues.
+ *
+ * \return the isosurfaces.
+ */
+vtkSmartPointer<vtkPolyData> marching_tets(
+    const VertexField3d       & vert,
+    const ConnectIndices4     & conn,
+    const double              * scalar,
+    const std::vector<double> & values);
+
+/**
+ * \brief As above, but only contour the given tetrahedra (e.g. those found
+ *        to straddle the isovalue by a SpanSpace).
+ *
+ * \param[in] tets  the tetrahedra to contour.
+ * \param[in] ntets the number of tetrahedra to contour.
+ */
+vtkSmartPointer<vtkPolyData> marching_tets(
+    const VertexField3d       & vert,
+    const ConnectIndices4     & conn,
+    const double              * scalar,
+    const std::vector<double> & values,
+    const vtkIdType           * tets,
+    size_t                      ntets);
+
+#endif  // MARCHING_TETS_H_
@@ -0,0 +1,87 @@
+/**
+ * \file   MemoryArena.h
+ * \author L. Nagy
+ *
+ * Copyright [2016] Lesleis Nagy. All rights reserved.
+ */
+
+#ifndef MEMORY_ARENA_H_
+#define MEMORY_ARENA_H_
+
+#include <cstddef>
+#include <memory_resource>
+
+/**
+ * \brief A monotonic arena for short lived (per load) allocations.
+ *
+ * Allocations are carved out of large blocks obtained from the upstream
+ * resource, deallocation is a no-op and all memory is given back in one shot
+ * by release(). The number of bytes handed out since the last release is
+ * tracked so that the high-water mark over the lifetime of the arena can be
+ * reported.
+ */
+class MemoryArena : public std::pmr::memory_resource
+{
+public:
+  /**
+   * \brief Create an arena.
+   *
+   * \param[in] initialSize the size of the first block requested from the
+   *                        upstream resource, subsequent blocks grow
+   *                        geometrically.
+   * \param[in] upstream    the resource from which blocks are obtained.
+   */
+  explicit MemoryArena(
+      size_t                      initialSize = 1 << 20,
+      std::pmr::memory_resource * upstream    = std::pmr::get_default_resource()) :
+    mMonotonic(initialSize, upstream), mBytesInUse(0), mHighWaterMark(0)
+  {}
+
+  MemoryArena(const MemoryArena &) = delete;
+  MemoryArena & operator= (const MemoryArena &) = delete;
+
+  /**
+   * \brief Release all memory allocated from the arena in one shot.
+   */
+  void release()
+  {
+    mMonotonic.release();
+    mBytesInUse = 0;
+  }
+
+  /// The number of bytes handed out since the last release.
+  size_t bytesInUse() const { return mBytesInUse; }
+
+  /// The largest number of bytes that were in use at any one time.
+  size_t highWaterMark() const { return mHighWaterMark; }
+
+private:
+  std::pmr::monotonic_buffer_resource mMonotonic;
+  size_t                              mBytesInUse;
+  size_t                              mHighWaterMark;
+
+  void * do_allocate(size_t bytes, size_t alignment) override
+  {
+    void * p = mMonotonic.allocate(bytes, alignment);
+
+    mBytesInUse += bytes;
+    if (mBytesInUse > mHighWaterMark) {
+      mHighWaterMark = mBytesInUse;
+    }
+
+    return p;
+  }
+
+  void do_deallocate(void * p, size_t bytes, size_t alignment) override
+  {
+    // Monotonic - memory is only given back on release().
+    mMonotonic.deallocate(p, bytes, alignment);
+  }
+
+  bool do_is_equal(const std::pmr::memory_resource & other) const noexcept override
+  {
+    return this == &other;
+  }
+};
+
+#endif  // MEMORY_ARENA_H_
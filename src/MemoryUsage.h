@@ -0,0 +1,38 @@
+/**
+ * \file   MemoryUsage.h
+ * \author L. Nagy
+ *
+ * Copyright [2016] Lesleis Nagy. All rights reserved.
+ */
+
+#ifndef MEMORY_USAGE_H_
+#define MEMORY_USAGE_H_
+
+#include <cstddef>
+
+/**
+ * \brief A breakdown of the memory held by a model (or a set of models).
+ */
+struct MemoryUsage {
+  /// The mesh (vertices, connectivity and cached mesh products).
+  size_t mesh     = 0;
+  /// The fields read from file (magnetisation).
+  size_t fields   = 0;
+  /// Derived arrays (helicity, ...).
+  size_t derived  = 0;
+  /// VTK pipeline data (grid geometry, glyphs, isosurfaces, ...).
+  size_t pipeline = 0;
+
+  size_t total() const { return mesh + fields + derived + pipeline; }
+
+  MemoryUsage & operator+= (const MemoryUsage & other)
+  {
+    mesh     += other.mesh;
+    fields   += other.fields;
+    derived  += other.derived;
+    pipeline += other.pipeline;
+    return *this;
+  }
+};
+
+#endif  // MEMORY_USAGE_H_
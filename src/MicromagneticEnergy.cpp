@@ -0,0 +1,206 @@
+/**
+ * \file   MicromagneticEnergy.cpp
+ * \author L. Nagy
+ *
+ * MIT License
+ *
+ * Copyright (c) [2016] Lesleis Nagy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+
+#include <cmath>
+#include <vector>
+
+#include <vtkSMPThreadLocal.h>
+#include <vtkSMPTools.h>
+
+#include "MicromagneticEnergy.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// Reduction functors.                                                       //
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Pass over tetrahedra, V_t*A|grad m|^2 in each tetrahedron (in mesh units)
+ * and its total.
+ */
+struct ExchangeFunctor
+{
+  const TetGeometry         & geometry;
+  const double              * m;
+  double                    * weighted;
+  vtkSMPThreadLocal<double>   local;
+  double                      total;
+
+  ExchangeFunctor(const TetGeometry & g, const double * m, double * weighted) :
+    geometry(g), m(m), weighted(weighted), local(0.0), total(0.0)
+  {}
+
+  // Thread locals are initialised from their exemplar.
+  void Initialize() {}
+
+  void operator() (vtkIdType begin, vtkIdType end)
+  {
+    const ConnectIndices4             & conn      = geometry.connectivity();
+    const std::vector<ShapeGradients> & gradients = geometry.gradients();
+    const std::vector<double>         & volumes   = geometry.volumes();
+
+    double & sum = local.Local();
+    for (vtkIdType t = begin; t < end; ++t) {
+      const Connect4       & c = conn[t];
+      const ShapeGradients & g = gradients[t];
+
+      // Row d of the (constant) Jacobian is grad m_d.
+      Vector3d grad[3] = {{0.0, 0.0, 0.0}, {0.0, 0.0, 0.0}, {0.0, 0.0, 0.0}};
+      for (int k = 0; k < 4; ++k) {
+        const double * mk = m + 3*c[k];
+        for (int d = 0; d < 3; ++d) {
+          grad[d] = grad[d] + g[k]*mk[d];
+        }
+      }
+
+      double e = dot(grad[0], grad[0]) + dot(grad[1], grad[1]) + dot(grad[2], grad[2]);
+      weighted[t] = volumes[t]*e;
+      sum += weighted[t];
+    }
+  }
+
+  void Reduce()
+  {
+    total = 0.0;
+    for (double sum : local) {
+      total += sum;
+    }
+  }
+};
+
+/**
+ * Pass over vertices, recovers the exchange density and evaluates the
+ * anisotropy and Zeeman densities, with their (lumped) integrals.
+ */
+struct VertexEnergyFunctor
+{
+  const TetGeometry          & geometry;
+  const double               * m;
+  const MaterialParameters   & params;
+  const double               * weighted;
+  double                       exchangeScale;
+  double                     * exchange;
+  double                     * anisotropy;
+  double                     * zeeman;
+  vtkSMPThreadLocal<Vector3d>  local;
+  double                       anisotropyTotal;
+  double                       zeemanTotal;
+
+  VertexEnergyFunctor(
+      const TetGeometry        & g,
+      const double             * m,
+      const MaterialParameters & params,
+      const double             * weighted,
+      double                     exchangeScale,
+      double                   * exchange,
+      double                   * anisotropy,
+      double                   * zeeman) :
+    geometry(g), m(m), params(params), weighted(weighted),
+    exchangeScale(exchangeScale), exchange(exchange), anisotropy(anisotropy),
+    zeeman(zeeman), local({.x = 0.0, .y = 0.0, .z = 0.0}),
+    anisotropyTotal(0.0), zeemanTotal(0.0)
+  {}
+
+  // Thread locals are initialised from their exemplar.
+  void Initialize() {}
+
+  void operator() (vtkIdType begin, vtkIdType end)
+  {
+    const std::vector<double> & nodalVolumes = geometry.nodalVolumes();
+
+    Vector3d u = cnormalize(params.easyAxis);
+
+    // Integrals of the anisotropy (x) and Zeeman (y) densities.
+    Vector3d & sum = local.Local();
+    for (vtkIdType v = begin; v < end; ++v) {
+      exchange[v] = exchangeScale*geometry.gather(v, weighted);
+
+      Vector3d mv = {.x = m[3*v], .y = m[3*v+1], .z = m[3*v+2]};
+      double   mn = norm(mv);
+      if (mn > 0.0) {
+        mv = mv/mn;
+      }
+
+      double ea = 0.0;
+      if (params.anisotropy == MaterialParameters::UNIAXIAL) {
+        double mu = dot(mv, u);
+        ea = params.k1*(1.0 - mu*mu);
+      } else if (params.anisotropy == MaterialParameters::CUBIC) {
+        double x2 = mv.x*mv.x, y2 = mv.y*mv.y, z2 = mv.z*mv.z;
+        ea = params.k1*(x2*y2 + y2*z2 + z2*x2) + params.k2*x2*y2*z2;
+      }
+      anisotropy[v] = ea;
+
+      zeeman[v] = -params.ms*dot(mv, params.field);
+
+      sum.x += nodalVolumes[v]*anisotropy[v];
+      sum.y += nodalVolumes[v]*zeeman[v];
+    }
+  }
+
+  void Reduce()
+  {
+    anisotropyTotal = 0.0;
+    zeemanTotal     = 0.0;
+    for (const Vector3d & sum : local) {
+      anisotropyTotal += sum.x;
+      zeemanTotal     += sum.y;
+    }
+  }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// Function compute_energies()                                               //
+///////////////////////////////////////////////////////////////////////////////
+
+EnergyTotals compute_energies(
+    const TetGeometry        & geometry,
+    const double             * m,
+    const MaterialParameters & params,
+    double                   * exchange,
+    double                   * anisotropy,
+    double                   * zeeman)
+{
+  // Gradients are per mesh unit and volumes in mesh units cubed.
+  double L  = params.lengthScale;
+  double L3 = L*L*L;
+
+  std::vector<double> weighted(geometry.ntet());
+  ExchangeFunctor exchangeFunctor(geometry, m, weighted.data());
+  vtkSMPTools::For(0, geometry.ntet(), exchangeFunctor);
+
+  VertexEnergyFunctor vertexFunctor(
+      geometry, m, params, weighted.data(), params.aex/(L*L),
+      exchange, anisotropy, zeeman);
+  vtkSMPTools::For(0, geometry.nvert(), vertexFunctor);
+
+  EnergyTotals totals;
+  totals.exchange   = params.aex*L*exchangeFunctor.total;
+  totals.anisotropy = L3*vertexFunctor.anisotropyTotal;
+  totals.zeeman     = L3*vertexFunctor.zeemanTotal;
+
+  return totals;
+}
@@ -0,0 +1,99 @@
+/**
+ * \file   MicromagneticEnergy.h
+ * \author L. Nagy
+ *
+ * MIT License
+ *
+ * Copyright (c) [2016] Lesleis Nagy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+
+#ifndef MICROMAGNETIC_ENERGY_H_
+#define MICROMAGNETIC_ENERGY_H_
+
+#include "Data.h"
+#include "TetGeometry.h"
+
+/**
+ * Material parameters used to evaluate micromagnetic energies, the defaults
+ * are for magnetite at room temperature.
+ */
+struct MaterialParameters {
+  enum Anisotropy { NONE, UNIAXIAL, CUBIC };
+
+  /// Saturation magnetisation (A/m).
+  double     ms          = 4.8E5;
+  /// Exchange constant (J/m).
+  double     aex         = 1.34E-11;
+  /// The type of magnetocrystalline anisotropy.
+  Anisotropy anisotropy  = CUBIC;
+  /// First anisotropy constant (J/m^3), Ku for uniaxial anisotropy.
+  double     k1          = -1.24E4;
+  /// Second (cubic) anisotropy constant (J/m^3).
+  double     k2          = -2.8E3;
+  /// Easy axis (uniaxial anisotropy only).
+  Vector3d   easyAxis    = {.x = 0.0, .y = 0.0, .z = 1.0};
+  /// Applied field B = mu0 H (T).
+  Vector3d   field       = {.x = 0.0, .y = 0.0, .z = 0.0};
+  /// The length of one mesh unit (m), meshes are usually in microns.
+  double     lengthScale = 1E-6;
+};
+
+/**
+ * Energy totals (J).
+ */
+struct EnergyTotals {
+  double exchange   = 0.0;
+  double anisotropy = 0.0;
+  double zeeman     = 0.0;
+  /// A (rough) estimate of the demagnetising energy, see demag_energy().
+  double demag      = 0.0;
+
+  double total() const { return exchange + anisotropy + zeeman + demag; }
+};
+
+/**
+ * \brief Compute per-vertex micromagnetic energy densities and their totals.
+ *
+ * The exchange energy density A|grad m|^2 is constant in each tetrahedron
+ * (using the P1 shape function gradients), its total is exact and the
+ * per-vertex density is the volume weighted average over the tetrahedra
+ * sharing the vertex. Anisotropy and Zeeman densities are evaluated at the
+ * vertices with unit m and integrated with the lumped nodal volumes. Each
+ * stage is a single parallel pass.
+ *
+ * \param[in]  geometry   the mesh operators.
+ * \param[in]  m          the magnetisation (3 components per vertex).
+ * \param[in]  params     the material parameters.
+ * \param[out] exchange   exchange energy density (J/m^3) per vertex.
+ * \param[out] anisotropy anisotropy energy density (J/m^3) per vertex.
+ * \param[out] zeeman     Zeeman energy density (J/m^3) per vertex.
+ *
+ * \return the energy totals.
+ */
+EnergyTotals compute_energies(
+    const TetGeometry        & geometry,
+    const double             * m,
+    const MaterialParameters & params,
+    double                   * exchange,
+    double                   * anisotropy,
+    double                   * zeeman);
+
+#endif  // MICROMAGNETIC_ENERGY_H_
@@ -0,0 +1,168 @@
+/**
+ * \file   PlaneSlicer.cpp
+ * \author L. Nagy
+ *
+ * MIT License
+ *
+ * Copyright (c) [2016] Lesleis Nagy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+
+#include <algorithm>
+#include <limits>
+
+#include <vtkSMPTools.h>
+
+#include "DebugMacros.h"
+#include "PlaneSlicer.h"
+#include "TetBVH.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// Function PlaneSlice::interpolate()                                        //
+///////////////////////////////////////////////////////////////////////////////
+
+void PlaneSlice::interpolate(const double * field, int ncomp, double * out) const
+{
+  vtkSMPTools::For(0, size(), [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType p = begin; p < end; ++p) {
+      uint   a = edges[p] >> 32, b = edges[p] & 0xffffffff;
+      double t = weights[p];
+      for (int k = 0; k < ncomp; ++k) {
+        out[ncomp*p + k] = (1.0 - t)*field[ncomp*a + k] + t*field[ncomp*b + k];
+      }
+    }
+  });
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Constructor                                                               //
+///////////////////////////////////////////////////////////////////////////////
+
+PlaneSlicer::PlaneSlicer(
+    const VertexField3d   & vert,
+    const ConnectIndices4 & conn,
+    const Vector3d        & normal) :
+  mVert(vert), mConn(conn), mNormal(normal),
+  mSpans(conn, heights(vert, normal).data())
+{
+  BoundingBox box = vertex_bounds(vert);
+
+  mCentre = 0.5*(Vertex3d({.x = box.lo[0], .y = box.lo[1], .z = box.lo[2]})
+               + Vertex3d({.x = box.hi[0], .y = box.hi[1], .z = box.hi[2]}));
+  mRadius = 0.5*norm(Vector3d({.x = box.hi[0] - box.lo[0],
+                               .y = box.hi[1] - box.lo[1],
+                               .z = box.hi[2] - box.lo[2]}));
+}
+
+std::vector<double> PlaneSlicer::heights(
+    const VertexField3d & vert,
+    const Vector3d      & normal)
+{
+  std::vector<double> height(vert.size());
+  vtkSMPTools::For(0, vert.size(), [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType v = begin; v < end; ++v) {
+      height[v] = normal.x*vert[v].x + normal.y*vert[v].y + normal.z*vert[v].z;
+    }
+  });
+  return height;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Function slice()                                                          //
+///////////////////////////////////////////////////////////////////////////////
+
+void PlaneSlicer::slice(
+    const Vertex3d & origin,
+    const Vector3d & normal,
+    PlaneSlice     & slice) const
+{
+  Vector3d n = normal/norm(normal);
+
+  // Heights along the plane normal, computed as in heights().
+  auto height = [&n](const Vertex3d & v) {
+    return n.x*v.x + n.y*v.y + n.z*v.z;
+  };
+  double d = height(origin);
+
+  // Tilting the normal from that of the slicer changes the height (relative
+  // to the plane) of a vertex at distance r from the origin by at most
+  // |tilt| r, so only tetrahedra within that of the plane along the slicer
+  // normal can be cut.
+  double r   = norm(origin - mCentre) + mRadius;
+  double eps = norm(n - mNormal)*r + 1E-9*mRadius;
+  double dm  = mNormal.x*origin.x + mNormal.y*origin.y + mNormal.z*origin.z;
+
+  std::vector<vtkIdType> tets;
+  mSpans.overlapping(dm - eps, dm + eps, tets);
+
+  // The crossed edges of each cut tetrahedron (three or four of its six),
+  // unused slots hold 'none' which sorts last.
+  static const int edge[6][2] = {{0, 1}, {0, 2}, {0, 3}, {1, 2}, {1, 3}, {2, 3}};
+  const Connect2::Key none = std::numeric_limits<Connect2::Key>::max();
+
+  std::vector<Connect2::Key> & keys = slice.edges;
+  keys.resize(6*tets.size());
+  vtkSMPTools::For(0, tets.size(), [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType i = begin; i < end; ++i) {
+      const Connect4 & c = mConn[tets[i]];
+      double h[4];
+      for (int k = 0; k < 4; ++k) {
+        h[k] = height(mVert[c[k]]);
+      }
+      for (int e = 0; e < 6; ++e) {
+        int a = edge[e][0], b = edge[e][1];
+        // Vertices on the plane are above it, as in marching_tets().
+        keys[6*i + e] = ((h[a] >= d) != (h[b] >= d))
+                      ? Connect2({{c[a], c[b]}}).key()
+                      : none;
+      }
+    }
+  });
+  vtkSMPTools::Sort(keys.begin(), keys.end());
+  keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+  if (!keys.empty() && keys.back() == none) {
+    keys.pop_back();
+  }
+
+  // Points, interpolated once per crossed edge.
+  vtkIdType npoints = keys.size();
+  slice.points.resize(npoints);
+  slice.weights.resize(npoints);
+  vtkSMPTools::For(0, npoints, [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType p = begin; p < end; ++p) {
+      uint   a  = keys[p] >> 32, b = keys[p] & 0xffffffff;
+      double ha = height(mVert[a]), hb = height(mVert[b]);
+      double t  = (d - ha)/(hb - ha);
+      slice.points[p]  = (1.0 - t)*mVert[a] + t*mVert[b];
+      slice.weights[p] = t;
+    }
+  });
+
+  DEBUG("Slice: " << tets.size() << " tetrahedra, " << npoints << " points");
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Function memoryBytes()                                                    //
+///////////////////////////////////////////////////////////////////////////////
+
+size_t PlaneSlicer::memoryBytes() const
+{
+  return mSpans.memoryBytes();
+}
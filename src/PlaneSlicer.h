@@ -0,0 +1,125 @@
+/**
+ * \file   PlaneSlicer.h
+ * \author L. Nagy
+ *
+ * MIT License
+ *
+ * Copyright (c) [2016] Lesleis Nagy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+
+#ifndef PLANE_SLICER_H_
+#define PLANE_SLICER_H_
+
+#include <vector>
+
+#include <vtkType.h>
+
+#include "Data.h"
+#include "SpanSpace.h"
+
+/**
+ * \brief The intersection of a plane with a tetrahedral mesh, as the points
+ *        at which the plane crosses mesh edges (the vertices of the
+ *        intersection polygons, each shared by the tetrahedra around its
+ *        edge).
+ */
+struct PlaneSlice {
+  /// The crossing points.
+  VertexField3d                points;
+  /// The (canonical key of the) edge crossed at each point.
+  std::vector<Connect2::Key>   edges;
+  /// The position of each point along its edge, from the first vertex.
+  std::vector<double>          weights;
+
+  size_t size() const { return points.size(); }
+
+  /**
+   * \brief Linearly interpolate a nodal field at the crossing points.
+   *
+   * \param[in]  field the field, ncomp values per mesh vertex.
+   * \param[in]  ncomp the number of components.
+   * \param[out] out   the interpolated field, ncomp values per point.
+   */
+  void interpolate(const double * field, int ncomp, double * out) const;
+};
+
+/**
+ * \brief Slices a tetrahedral mesh with planes of (about) one orientation.
+ *
+ * The tetrahedra are indexed by their range of heights along the normal of
+ * the slicer with a SpanSpace, so that moving the plane (along its normal)
+ * only visits the tetrahedra the plane actually cuts. A plane with a nearby
+ * normal is sliced exactly too, from the tetrahedra whose heights are within
+ * the largest change in height that the tilt can cause, so that rotating a
+ * plane need not rebuild the index. Crossing points are welded by sorting
+ * the keys of their edges, cf. marching_tets().
+ */
+class PlaneSlicer
+{
+public:
+  /**
+   * \brief Build the index, the mesh must outlive the slicer.
+   *
+   * \param[in] vert   the mesh vertices.
+   * \param[in] conn   the mesh tetrahedra.
+   * \param[in] normal the (unit) plane normal.
+   */
+  PlaneSlicer(
+      const VertexField3d   & vert,
+      const ConnectIndices4 & conn,
+      const Vector3d        & normal);
+
+  PlaneSlicer(const PlaneSlicer &) = delete;
+  PlaneSlicer & operator= (const PlaneSlicer &) = delete;
+
+  const Vector3d & normal() const { return mNormal; }
+
+  /**
+   * \brief Slice the mesh with a plane, the cost grows with the angle
+   *        between its normal and that of the slicer.
+   *
+   * \param[in]  origin a point on the plane.
+   * \param[in]  normal the plane normal.
+   * \param[out] slice  the intersection.
+   */
+  void slice(
+      const Vertex3d & origin,
+      const Vector3d & normal,
+      PlaneSlice     & slice) const;
+
+  /// The memory used by the slicer.
+  size_t memoryBytes() const;
+
+private:
+  const VertexField3d   & mVert;
+  const ConnectIndices4 & mConn;
+  Vector3d                mNormal;
+  /// The centre of the bounding box of the mesh and its half diagonal.
+  Vertex3d                mCentre;
+  double                  mRadius;
+  SpanSpace               mSpans;
+
+  static std::vector<double> heights(
+      const VertexField3d & vert,
+      const Vector3d      & normal);
+};
+
+#endif  // PLANE_SLICER_H_
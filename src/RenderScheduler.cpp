@@ -0,0 +1,91 @@
+/**
+ * \file   RenderScheduler.cpp
+ * \author L. Nagy
+ *
+ * MIT License
+ *
+ * Copyright (c) [2016] Lesleis Nagy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+
+#include <algorithm>
+#include <cmath>
+
+#include <QGuiApplication>
+#include <QScreen>
+
+#include "RenderScheduler.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// Constructor                                                               //
+///////////////////////////////////////////////////////////////////////////////
+
+RenderScheduler::RenderScheduler(vtkSmartPointer<vtkRenderWindow> window) :
+  mWindow(window), mInterval(16)
+{
+  QScreen * screen = QGuiApplication::primaryScreen();
+  if (screen != NULL && screen->refreshRate() > 0.0) {
+    mInterval = std::max(1, (int)std::floor(1000.0/screen->refreshRate()));
+  }
+
+  mTimer.setSingleShot(true);
+  QObject::connect(&mTimer, &QTimer::timeout, [this]() { flush(); });
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Function request()                                                        //
+///////////////////////////////////////////////////////////////////////////////
+
+void RenderScheduler::request(std::function<void()> action)
+{
+  if (action) {
+    mAction = action;
+  }
+
+  if (mTimer.isActive()) {
+    return;
+  }
+
+  qint64 elapsed = mSinceRender.isValid() ? mSinceRender.elapsed() : mInterval;
+  mTimer.start((int)std::max<qint64>(0, mInterval - elapsed));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Function flush()                                                          //
+///////////////////////////////////////////////////////////////////////////////
+
+void RenderScheduler::flush()
+{
+  mTimer.stop();
+
+  // NOTE: the action may request another render, that is served next time.
+  std::function<void()> action;
+  std::swap(action, mAction);
+  if (action) {
+    action();
+  }
+
+  mWindow->Render();
+  mSinceRender.restart();
+
+  if (mRendered) {
+    mRendered();
+  }
+}
@@ -0,0 +1,88 @@
+/**
+ * \file   RenderScheduler.h
+ * \author L. Nagy
+ *
+ * MIT License
+ *
+ * Copyright (c) [2016] Lesleis Nagy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+
+#ifndef RENDER_SCHEDULER_H_
+#define RENDER_SCHEDULER_H_
+
+#include <functional>
+
+#include <QElapsedTimer>
+#include <QTimer>
+
+#include <vtkRenderWindow.h>
+#include <vtkSmartPointer.h>
+
+/**
+ * \brief Coalesces render requests for a window to at most one render per
+ *        display refresh.
+ *
+ * Requests are served from the Qt event loop, no sooner than one refresh
+ * interval after the previous render. A request made while one is pending
+ * replaces its action, so however many requests arrive in between (e.g.
+ * from a held key) only the latest requested state is built and drawn.
+ */
+class RenderScheduler
+{
+public:
+  explicit RenderScheduler(vtkSmartPointer<vtkRenderWindow> window);
+
+  RenderScheduler(const RenderScheduler &) = delete;
+  RenderScheduler & operator= (const RenderScheduler &) = delete;
+
+  /**
+   * \brief Request a render.
+   *
+   * \param[in] action run just before rendering (e.g. to update the props),
+   *                   replacing the action of a pending request. Empty to
+   *                   keep the pending action, if any.
+   */
+  void request(std::function<void()> action = std::function<void()>());
+
+  /**
+   * \brief Serve a pending request now.
+   */
+  void flush();
+
+  /**
+   * \brief Set a callback run after every render (e.g. to report state that
+   *        the render's action may have built).
+   */
+  void setRendered(std::function<void()> rendered) { mRendered = rendered; }
+
+  /// The refresh interval in milliseconds.
+  int interval() const { return mInterval; }
+
+private:
+  vtkSmartPointer<vtkRenderWindow> mWindow;
+  int                              mInterval;
+  QTimer                           mTimer;
+  QElapsedTimer                    mSinceRender;
+  std::function<void()>            mAction;
+  std::function<void()>            mRendered;
+};
+
+#endif  // RENDER_SCHEDULER_H_
@@ -0,0 +1,130 @@
+/**
+ * \file   SpanSpace.cpp
+ * \author L. Nagy
+ *
+ * MIT License
+ *
+ * Copyright (c) [2016] Lesleis Nagy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+
+#include <algorithm>
+
+#include <vtkSMPThreadLocal.h>
+#include <vtkSMPTools.h>
+
+#include "SpanSpace.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// Constructor                                                               //
+///////////////////////////////////////////////////////////////////////////////
+
+SpanSpace::SpanSpace(const ConnectIndices4 & conn, const double * scalar) :
+  mSpans(conn.size())
+{
+  vtkIdType ntet = conn.size();
+
+  vtkSMPTools::For(0, ntet, [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType t = begin; t < end; ++t) {
+      const Connect4 & c = conn[t];
+      double lo = scalar[c[0]], hi = lo;
+      for (int k = 1; k < 4; ++k) {
+        lo = std::min(lo, scalar[c[k]]);
+        hi = std::max(hi, scalar[c[k]]);
+      }
+      mSpans[t] = {lo, hi, t};
+    }
+  });
+
+  vtkSMPTools::Sort(mSpans.begin(), mSpans.end(),
+      [](const Span & lhs, const Span & rhs) {
+        return lhs.min < rhs.min || (lhs.min == rhs.min && lhs.tet < rhs.tet);
+      });
+
+  vtkIdType nbucket = (ntet + BucketSize - 1)/BucketSize;
+  mBucketMin.resize(nbucket);
+  mBucketMax.resize(nbucket);
+  vtkSMPTools::For(0, nbucket, [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType b = begin; b < end; ++b) {
+      auto first = mSpans.begin() + b*BucketSize;
+      auto last  = mSpans.begin() + std::min((vtkIdType)((b + 1)*BucketSize), ntet);
+
+      mBucketMin[b] = first->min;
+      std::sort(first, last, [](const Span & lhs, const Span & rhs) {
+        return lhs.max > rhs.max || (lhs.max == rhs.max && lhs.tet < rhs.tet);
+      });
+      mBucketMax[b] = first->max;
+    }
+  });
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Function straddling()                                                     //
+///////////////////////////////////////////////////////////////////////////////
+
+void SpanSpace::straddling(double value, std::vector<vtkIdType> & tets) const
+{
+  overlapping(value, value, tets);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Function overlapping()                                                    //
+///////////////////////////////////////////////////////////////////////////////
+
+void SpanSpace::overlapping(double lo, double hi, std::vector<vtkIdType> & tets) const
+{
+  // Buckets are in order of increasing minimum, so only those before the
+  // first bucket whose minimum exceeds the interval can contribute.
+  vtkIdType nbucket = std::upper_bound(mBucketMin.begin(), mBucketMin.end(), hi)
+                    - mBucketMin.begin();
+
+  vtkSMPThreadLocal< std::vector<vtkIdType> > local;
+  vtkSMPTools::For(0, nbucket, [&](vtkIdType begin, vtkIdType end) {
+    std::vector<vtkIdType> & found = local.Local();
+    for (vtkIdType b = begin; b < end; ++b) {
+      if (mBucketMax[b] < lo) {
+        continue;
+      }
+      size_t last = std::min((size_t)(b + 1)*BucketSize, mSpans.size());
+      for (size_t i = b*BucketSize; i < last && mSpans[i].max >= lo; ++i) {
+        if (mSpans[i].min <= hi) {
+          found.push_back(mSpans[i].tet);
+        }
+      }
+    }
+  });
+
+  tets.clear();
+  for (const std::vector<vtkIdType> & found : local) {
+    tets.insert(tets.end(), found.begin(), found.end());
+  }
+  vtkSMPTools::Sort(tets.begin(), tets.end());
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Function memoryBytes()                                                    //
+///////////////////////////////////////////////////////////////////////////////
+
+size_t SpanSpace::memoryBytes() const
+{
+  return mSpans.capacity()*sizeof(Span)
+       + mBucketMin.capacity()*sizeof(double)
+       + mBucketMax.capacity()*sizeof(double);
+}
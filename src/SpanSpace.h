@@ -0,0 +1,94 @@
+/**
+ * \file   SpanSpace.h
+ * \author L. Nagy
+ *
+ * MIT License
+ *
+ * Copyright (c) [2016] Lesleis Nagy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+
+#ifndef SPAN_SPACE_H_
+#define SPAN_SPACE_H_
+
+#include <vector>
+
+#include <vtkType.h>
+
+#include "Data.h"
+
+/**
+ * \brief A span space index over the tetrahedra of a mesh for one scalar
+ *        field, used to find the tetrahedra that straddle an isovalue
+ *        without visiting the whole mesh.
+ *
+ * Tetrahedra are sorted by the minimum of the scalar over their vertices and
+ * grouped in to fixed size buckets, within a bucket they are sorted by
+ * decreasing maximum. A query skips whole buckets whose minimum is above,
+ * or whose maximum is below, the isovalue and stops scanning a bucket at the
+ * first tetrahedron whose maximum is below it. Building the index is
+ * parallel, as are queries (over buckets).
+ */
+class SpanSpace
+{
+public:
+  /// The number of tetrahedra in a bucket.
+  static const size_t BucketSize = 256;
+
+  SpanSpace(const ConnectIndices4 & conn, const double * scalar);
+
+  /**
+   * \brief Find the tetrahedra that straddle a value.
+   *
+   * \param[in]  value the value.
+   * \param[out] tets  the (sorted) indices of the tetrahedra with value in
+   *                   [min, max] of the scalar over their vertices.
+   */
+  void straddling(double value, std::vector<vtkIdType> & tets) const;
+
+  /**
+   * \brief Find the tetrahedra whose range overlaps an interval.
+   *
+   * \param[in]  lo   the bottom of the interval.
+   * \param[in]  hi   the top of the interval.
+   * \param[out] tets the (sorted) indices of the tetrahedra with min <= hi
+   *                  and max >= lo of the scalar over their vertices.
+   */
+  void overlapping(double lo, double hi, std::vector<vtkIdType> & tets) const;
+
+  /// The memory used by the index.
+  size_t memoryBytes() const;
+
+private:
+  /// The range of the scalar over a tetrahedron.
+  struct Span {
+    double    min;
+    double    max;
+    vtkIdType tet;
+  };
+
+  std::vector<Span>     mSpans;
+  /// The smallest minimum in each bucket.
+  std::vector<double>   mBucketMin;
+  /// The largest maximum in each bucket.
+  std::vector<double>   mBucketMax;
+};
+
+#endif  // SPAN_SPACE_H_
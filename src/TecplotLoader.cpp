@@ -10,7 +10,8 @@
 
 #include <cstdio>
 
-TecplotLoader::TecplotLoader() {
+TecplotLoader::TecplotLoader(std::pmr::memory_resource * resource) :
+  m_resource(resource) {
   using std::string;
   using std::stringstream;
 
@@ -164,10 +165,9 @@ void TecplotLoader::header(std::string const & fileName,
                            size_t            & nvert,
                            size_t            & nelem,
                            size_t            & nzone) {
-  using std::string;
   using std::ifstream;
 
-  string line;
+  std::pmr::string line(m_resource);
 
   nzone = 0;
 
@@ -176,7 +176,7 @@ void TecplotLoader::header(std::string const & fileName,
   if (file.is_open()) {
     while (file) {
       getline(file, line);
-      if (parseZone(line, nvert, nelem)) {
+      if (parseZone(line.c_str(), nvert, nelem)) {
         foundHeader = true;
         (nzone)++;
       }
@@ -199,12 +199,11 @@ void TecplotLoader::load(std::string        const & fileName,
                          ConnectIndices4          & eindex,
                          VectorFields3d           & fields) {
   using std::string;
-  using std::vector;
   using std::ifstream;
 
   loaderStatus state = START;
 
-  string line;
+  std::pmr::string line(m_resource);
 
   // Retrive no of vertices and elements.
   size_t nvert = 0, nelem = 0, nzone = 0;
@@ -212,9 +211,9 @@ void TecplotLoader::load(std::string        const & fileName,
   /* Open file */
   ifstream file(fileName.c_str());
 
-  vector<double> vcl;
-  vector<uint>   til;
-  vector<double> fld;
+  std::pmr::vector<double> vcl(m_resource);
+  std::pmr::vector<uint>   til(m_resource);
+  std::pmr::vector<double> fld(m_resource);
 
   if (file.is_open()) {
     double vx, vy, vz, fx, fy, fz;
@@ -228,14 +227,17 @@ void TecplotLoader::load(std::string        const & fileName,
       if (!line.empty()) {
         switch (state) {
           case START:
-            if (parseVars(line, vars)) {
+            if (parseVars(line.c_str(), vars)) {
               // Everything is OK - do nothing.
-            } else if (parseTitle(line, title)) {
+            } else if (parseTitle(line.c_str(), title)) {
               // Everything is OK - do nothing.
-            } else if (parseZone(line, nvert, nelem)) {
+            } else if (parseZone(line.c_str(), nvert, nelem)) {
               // Everything is OK - switch state
               state = ZONE1;
               nzone = nzone + 1;
+              vcl.reserve(3*nvert);
+              fld.reserve(3*nvert);
+              til.reserve(4*nelem);
             } else {
               // In state 'START' but matched something that shouldn't be there.
               ERROR("In state 'START' but matched something that shouldn't be there.");
@@ -244,7 +246,7 @@ void TecplotLoader::load(std::string        const & fileName,
             }
             break;
           case ZONE1:
-            if (parseFem(line)) {
+            if (parseFem(line.c_str())) {
               // Everything is OK - switch state
               state = FEM1;
             } else {
@@ -254,7 +256,7 @@ void TecplotLoader::load(std::string        const & fileName,
             }
             break;
           case FEM1:
-            if (parseVertAndField(line, vx, vy, vz, fx, fy, fz)) {
+            if (parseVertAndField(line.c_str(), vx, vy, vz, fx, fy, fz)) {
               // Everything is OK, push data.
               vcl.push_back(vx);
               vcl.push_back(vy);
@@ -263,7 +265,7 @@ void TecplotLoader::load(std::string        const & fileName,
               fld.push_back(fx);
               fld.push_back(fy);
               fld.push_back(fz);
-            } else if (parseTet(line, n0, n1, n2, n3)) {
+            } else if (parseTet(line.c_str(), n0, n1, n2, n3)) {
               // Everything is OK, push data.
               switch (fileIndexing) {
                 case ZERO_INDEXING:
@@ -282,7 +284,7 @@ void TecplotLoader::load(std::string        const & fileName,
                   throw TecplotFileParseException("257");
                   break;
               }
-            } else if (parseZone(line, nvert, nelem)) {
+            } else if (parseZone(line.c_str(), nvert, nelem)) {
               // Everything is OK, switch state.
               state = ZONE2;
               nzone = nzone + 1;
@@ -294,7 +296,7 @@ void TecplotLoader::load(std::string        const & fileName,
             }
             break;
           case ZONE2:
-            if (parseFem(line)) {
+            if (parseFem(line.c_str())) {
               // Everything is OK, switch state.
               state = FEM2;
             } else {
@@ -305,12 +307,12 @@ void TecplotLoader::load(std::string        const & fileName,
             }
             break;
           case FEM2:
-            if (parseF(line, vx, vy, vz)) {
+            if (parseF(line.c_str(), vx, vy, vz)) {
               // Everything is OK, push data.
               fld.push_back(vx);
               fld.push_back(vy);
               fld.push_back(vz);
-            } else if (parseZone(line, nvert, nelem)) {
+            } else if (parseZone(line.c_str(), nvert, nelem)) {
               // Everything is OK, switch state.
               state = ZONE2;
               nzone = nzone + 1;
@@ -351,7 +353,7 @@ void TecplotLoader::load(std::string        const & fileName,
     vcoord.resize(nvert);
     eindex.resize(nelem);
     fields.resize(nzone);
-    for (auto field : fields) {
+    for (auto & field : fields) {
       field.resize(nvert);
     }
 
@@ -368,10 +370,10 @@ void TecplotLoader::load(std::string        const & fileName,
       }
     }
     for (uint i = 0; i < nelem; ++i) {
-      eindex.at(i).n0 = til[4*i + 0];
-      eindex.at(i).n1 = til[4*i + 1];
-      eindex.at(i).n2 = til[4*i + 2];
-      eindex.at(i).n3 = til[4*i + 3];
+      eindex.at(i)[0] = til[4*i + 0];
+      eindex.at(i)[1] = til[4*i + 1];
+      eindex.at(i)[2] = til[4*i + 2];
+      eindex.at(i)[3] = til[4*i + 3];
     }
   } else {
     throw TecplotFileAccessException();
@@ -387,12 +389,11 @@ void TecplotLoader::load(std::string        const & fileName,
                          ConnectIndices4          & eindex,
                          VectorField3d            & field) {
   using std::string;
-  using std::vector;
   using std::ifstream;
 
   loaderStatus state = START;
 
-  string line;
+  std::pmr::string line(m_resource);
 
   // Retrive no of vertices and elements.
   size_t nvert = 0, nelem = 0; //, nzone = 0;
@@ -400,9 +401,9 @@ void TecplotLoader::load(std::string        const & fileName,
   /* Open file */
   ifstream file(fileName.c_str());
 
-  vector<double> vcl;
-  vector<uint>   til;
-  vector<double> fld;
+  std::pmr::vector<double> vcl(m_resource);
+  std::pmr::vector<uint>   til(m_resource);
+  std::pmr::vector<double> fld(m_resource);
 
   if (file.is_open()) {
     double vx, vy, vz, fx, fy, fz;
@@ -418,16 +419,19 @@ void TecplotLoader::load(std::string        const & fileName,
       if (!line.empty()) {
         switch (state) {
           case START:
-            if (parseVars(line, vars)) {
+            if (parseVars(line.c_str(), vars)) {
               // Everything is OK - do nothing.
               //std::cout << "Parsed variables: " << line << std::endl;
-            } else if (parseTitle(line, title)) {
+            } else if (parseTitle(line.c_str(), title)) {
               // Everything is OK - do nothing.
               //std::cout << "Parsed title: " << line << std::endl;
-            } else if (parseZoneAndFem(line, nvert, nelem)) {
+            } else if (parseZoneAndFem(line.c_str(), nvert, nelem)) {
               // Everything is OK - switch state
               //std::cout << "Parsed zone and FEM (switching state): " << line << std::endl;
               state = FEM1;
+              vcl.reserve(3*nvert);
+              fld.reserve(3*nvert);
+              til.reserve(4*nelem);
             } else {
               // In state 'START' but matched something that shouldn't be there.
               ERROR("In state 'START' but matched something that shouldn't be there.");
@@ -436,7 +440,7 @@ void TecplotLoader::load(std::string        const & fileName,
             }
             break;
           case FEM1:
-            if (parseVertAndField(line, vx, vy, vz, fx, fy, fz)) {
+            if (parseVertAndField(line.c_str(), vx, vy, vz, fx, fy, fz)) {
               // Everything is OK, push data.
               vcl.push_back(vx);
               vcl.push_back(vy);
@@ -454,7 +458,7 @@ void TecplotLoader::load(std::string        const & fileName,
                         << std::endl;
                */
 
-            } else if (parseTet(line, n0, n1, n2, n3)) {
+            } else if (parseTet(line.c_str(), n0, n1, n2, n3)) {
               // Everything is OK, push data.
               switch (fileIndexing) {
                 case ZERO_INDEXING:
@@ -522,27 +526,25 @@ void TecplotLoader::load(std::string        const & fileName,
       field.at(i).z = fld[3*i + 2];
     }
     for (uint i = 0; i < nelem; ++i) {
-      eindex.at(i).n0 = til[4*i + 0];
-      eindex.at(i).n1 = til[4*i + 1];
-      eindex.at(i).n2 = til[4*i + 2];
-      eindex.at(i).n3 = til[4*i + 3];
+      eindex.at(i)[0] = til[4*i + 0];
+      eindex.at(i)[1] = til[4*i + 1];
+      eindex.at(i)[2] = til[4*i + 2];
+      eindex.at(i)[3] = til[4*i + 3];
     }
   } else {
     throw TecplotFileAccessException();
   }
 }
 
-bool TecplotLoader::parseTitle(std::string const & line,
+bool TecplotLoader::parseTitle(const char        * line,
                                std::string       & title) {
-  using std::vector;
-
-  size_t nmatches = 10;
+  const size_t nmatches = 10;
 
-  vector<regmatch_t> matches(nmatches);
+  regmatch_t matches[nmatches];
 
-  const char * cline = line.c_str();
+  const char * cline = line;
 
-  int reti = regexec(&m_regexTitle, cline, nmatches, &matches[0], 0);
+  int reti = regexec(&m_regexTitle, cline, nmatches, matches, 0);
   if (!reti) {
     title = extract_string(cline, &matches[1]);
 
@@ -552,18 +554,16 @@ bool TecplotLoader::parseTitle(std::string const & line,
   return false;
 }
 
-bool TecplotLoader::parseZone(std::string const & line,
+bool TecplotLoader::parseZone(const char        * line,
                               size_t            & nvert,
                               size_t            & nelem) {
-  using std::vector;
-
-  size_t nmatches = 10;
+  const size_t nmatches = 10;
 
-  vector<regmatch_t> matches(nmatches);
+  regmatch_t matches[nmatches];
 
-  const char * cline = line.c_str();
+  const char * cline = line;
 
-  int reti = regexec(&m_regexZone, cline, nmatches, &matches[0], 0);
+  int reti = regexec(&m_regexZone, cline, nmatches, matches, 0);
   if (!reti) {
     nvert = extract_size_t(cline, &matches[2]);
     nelem = extract_size_t(cline, &matches[3]);
@@ -574,17 +574,15 @@ bool TecplotLoader::parseZone(std::string const & line,
   return false;
 }
 
-bool TecplotLoader::parseVars(std::string const & line,
+bool TecplotLoader::parseVars(const char        * line,
                               std::string       & vars) {
-  using std::vector;
+  const size_t nmatches = 10;
 
-  size_t nmatches = 10;
+  regmatch_t matches[nmatches];
 
-  vector<regmatch_t> matches(nmatches);
+  const char * cline = line;
 
-  const char * cline = line.c_str();
-
-  int reti = regexec(&m_regexVars, cline, nmatches, &matches[0], 0);
+  int reti = regexec(&m_regexVars, cline, nmatches, matches, 0);
   if (!reti) {
     vars = extract_string(cline, &matches[1]);
 
@@ -594,16 +592,14 @@ bool TecplotLoader::parseVars(std::string const & line,
   return false;
 }
 
-bool TecplotLoader::parseFem(std::string const &line) {
-  using std::vector;
-
-  size_t nmatches = 10;
+bool TecplotLoader::parseFem(const char * line) {
+  const size_t nmatches = 10;
 
-  vector<regmatch_t> matches(nmatches);
+  regmatch_t matches[nmatches];
 
-  const char * cline = line.c_str();
+  const char * cline = line;
 
-  int reti = regexec(&m_regexFem, cline, nmatches, &matches[0], 0);
+  int reti = regexec(&m_regexFem, cline, nmatches, matches, 0);
   if (!reti) {
     return true;
   }
@@ -611,22 +607,20 @@ bool TecplotLoader::parseFem(std::string const &line) {
   return false;
 }
 
-bool TecplotLoader::parseVertAndField(std::string const & line,
+bool TecplotLoader::parseVertAndField(const char        * line,
                                       double            & vx,
                                       double            & vy,
                                       double            & vz,
                                       double            & fx,
                                       double            & fy,
                                       double            & fz) {
-  using std::vector;
+  const size_t nmatches = 20;
 
-  size_t nmatches = 20;
+  regmatch_t matches[nmatches];
 
-  vector<regmatch_t> matches(nmatches);
+  const char * cline = line;
 
-  const char * cline = line.c_str();
-
-  int reti = regexec(&m_regexVertAndField, cline, nmatches, &matches[0], 0);
+  int reti = regexec(&m_regexVertAndField, cline, nmatches, matches, 0);
   //std::cout << "nmatches: " << nmatches << std::endl;
 
   if (!reti) {
@@ -644,21 +638,19 @@ bool TecplotLoader::parseVertAndField(std::string const & line,
   return false;
 }
 
-bool TecplotLoader::parseTet(std::string const & line,
+bool TecplotLoader::parseTet(const char        * line,
                              uint              & n0,
                              uint              & n1,
                              uint              & n2,
                              uint              & n3) {
 
-  using std::vector;
-
-  size_t nmatches = 10;
+  const size_t nmatches = 10;
 
-  vector<regmatch_t> matches(nmatches);
+  regmatch_t matches[nmatches];
 
-  const char * cline = line.c_str();
+  const char * cline = line;
 
-  int reti = regexec(&m_regexTet, cline, nmatches, &matches[0], 0);
+  int reti = regexec(&m_regexTet, cline, nmatches, matches, 0);
   if (!reti) {
     n0 = extract_uint(cline, &matches[1]);
     n1 = extract_uint(cline, &matches[2]);
@@ -671,19 +663,17 @@ bool TecplotLoader::parseTet(std::string const & line,
   return false;
 }
 
-bool TecplotLoader::parseF(std::string const & line,
+bool TecplotLoader::parseF(const char        * line,
                            double            & fx,
                            double            & fy,
                            double            & fz) {
-  using std::vector;
+  const size_t nmatches = 10;
 
-  size_t nmatches = 10;
+  regmatch_t matches[nmatches];
 
-  vector<regmatch_t> matches(nmatches);
+  const char * cline = line;
 
-  const char * cline = line.c_str();
-
-  int reti = regexec(&m_regexF, cline, nmatches, &matches[0], 0);
+  int reti = regexec(&m_regexF, cline, nmatches, matches, 0);
   if (!reti) {
     fx = extract_double(cline, &matches[1]);
     fy = extract_double(cline, &matches[3]);
@@ -695,18 +685,16 @@ bool TecplotLoader::parseF(std::string const & line,
   return false;
 }
 
-bool TecplotLoader::parseZoneAndFem(std::string const & line,
+bool TecplotLoader::parseZoneAndFem(const char        * line,
                                     size_t            & nvert,
                                     size_t            & nelem) {
-  using std::vector;
-
-  size_t nmatches = 10;
+  const size_t nmatches = 10;
 
-  vector<regmatch_t> matches(nmatches);
+  regmatch_t matches[nmatches];
 
-  const char * cline = line.c_str();
+  const char * cline = line;
 
-  int reti = regexec(&m_regexZoneAndFem, cline, nmatches, &matches[0], 0);
+  int reti = regexec(&m_regexZoneAndFem, cline, nmatches, matches, 0);
   if (!reti) {
     nvert = extract_size_t(cline, &matches[2]);
     nelem = extract_size_t(cline, &matches[3]);
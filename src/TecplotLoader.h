@@ -15,6 +15,7 @@
 #include <exception>
 #include <fstream>
 #include <iostream>
+#include <memory_resource>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -142,8 +143,13 @@ class TecplotLoader : public Loader {
      * \brief Default constructor.
      *
      * Creates a TecplotLoader and initialises its internal file parsing state.
+     *
+     * \param[in] resource the memory resource from which per-line and staging
+     *                     buffers are allocated while parsing (e.g. a per-load
+     *                     MemoryArena).
      */
-    TecplotLoader();
+    TecplotLoader(
+        std::pmr::memory_resource * resource = std::pmr::get_default_resource());
 
     /**
      * \brief Read header information.
@@ -204,6 +210,8 @@ class TecplotLoader : public Loader {
       ZONEANDFEM
     };
 
+    std::pmr::memory_resource * m_resource;
+
     regex_t m_regexTitle;
     regex_t m_regexZone;
     regex_t m_regexVars;
@@ -216,55 +224,55 @@ class TecplotLoader : public Loader {
     /**
      * \brief Function to parse the title line.
      * 
-     * \param[in]  line  the line being parsed.
+     * \param[in]  line  the (null terminated) line being parsed.
      * \param[out] title the title in the line being parsed.
      *
      * \return true if the input line was matched as a title line, otherwise
      *         returns false.
      */
-    bool parseTitle(std::string const & line,
+    bool parseTitle(const char        * line,
                     std::string       & title);
 
     /**
      * \brief Function to parse a zone line.
      * 
-     * \param[in]  line  the line being parsed.
+     * \param[in]  line  the (null terminated) line being parsed.
      * \param[out] nvert the number of vertices in the zone line.
      * \param[out] nelem the number of elements in the zone line.
      *
      * \return true if the input line was matched as a zone line, otherwise
      *         returns false.
      */
-    bool parseZone(std::string const & line,
+    bool parseZone(const char        * line,
                    size_t            & nvert,
                    size_t            & nelem);
 
     /**
      * \brief Function to parse a vars line.
      * 
-     * \param[in]  line  the line being parsed.
+     * \param[in]  line  the (null terminated) line being parsed.
      * \param[out] vars  the vars information in the vars line.
      *
      * \return true if the input line was matched as a vars line, otherwise
      *         returns false.
      */
-    bool parseVars(std::string const & line,
+    bool parseVars(const char        * line,
                    std::string       & vars);
 
     /**
      * \brief Function to parse a fem line.
      * 
-     * \param[in]  line the line being parsed.
+     * \param[in]  line the (null terminated) line being parsed.
      *
      * \return true if the input line was matched as a fem line, otherwise
      *         returns false.
      */
-    bool parseFem(std::string const & line);
+    bool parseFem(const char * line);
 
     /**
      * \brief Function to parse a vertex and field line.
      * 
-     * \param[in]  line  the line being parsed.
+     * \param[in]  line  the (null terminated) line being parsed.
      * \param[out]   vx  the x coordinate of the vertex.
      * \param[out]   vy  the y coordinate of the vertex.
      * \param[out]   vz  the z coordinate of the vertex.
@@ -275,7 +283,7 @@ class TecplotLoader : public Loader {
      * \return true if the input line was matched as a vertex & field line, 
      *         otherwise returns false.
      */
-    bool parseVertAndField(std::string const & line,
+    bool parseVertAndField(const char        * line,
                            double            & vx,
                            double            & vy,
                            double            & vz,
@@ -286,7 +294,7 @@ class TecplotLoader : public Loader {
     /**
      * \brief Function to parse a tetrahedral element line.
      * 
-     * \param[in]  line  the line being parsed.
+     * \param[in]  line  the (null terminated) line being parsed.
      * \param[out]   n0  the first index of the tetrahedron. 
      * \param[out]   n1  the second index of the tetrahedron. 
      * \param[out]   n2  the third index of the tetrahedron. 
@@ -295,7 +303,7 @@ class TecplotLoader : public Loader {
      * \return true if the input line was matched as a tetrahedral element line, 
      *         otherwise returns false.
      */
-    bool parseTet(std::string const & line,
+    bool parseTet(const char        * line,
                   uint              & n0,
                   uint              & n1,
                   uint              & n2,
@@ -304,7 +312,7 @@ class TecplotLoader : public Loader {
     /**
      * \brief Function to parse a field line.
      * 
-     * \param[in]  line  the line being parsed.
+     * \param[in]  line  the (null terminated) line being parsed.
      * \param[out]   fx  the x coordinate of the field.
      * \param[out]   fy  the y coordinate of the field.
      * \param[out]   fz  the z coordinate of the field.
@@ -312,7 +320,7 @@ class TecplotLoader : public Loader {
      * \return true if the input line was matched as a field line, 
      *         otherwise returns false.
      */
-    bool parseF(std::string const & line,
+    bool parseF(const char        * line,
                 double            & fx,
                 double            & fy,
                 double            & fz);
@@ -320,14 +328,14 @@ class TecplotLoader : public Loader {
     /**
      * \brief Function to parse a zone line.
      * 
-     * \param[in]  line  the line being parsed.
+     * \param[in]  line  the (null terminated) line being parsed.
      * \param[out] nvert the number of vertices in the zone line.
      * \param[out] nelem the number of elements in the zone line.
      *
      * \return true if the input line was matched as a zone line, otherwise
      *         returns false.
      */
-    bool parseZoneAndFem(std::string const & line,
+    bool parseZoneAndFem(const char        * line,
                          size_t            & nvert,
                          size_t            & nelem);
 
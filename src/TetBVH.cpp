@@ -0,0 +1,310 @@
+/**
+ * \file   TetBVH.cpp
+ * \author L. Nagy
+ *
+ * MIT License
+ *
+ * Copyright (c) [2016] Lesleis Nagy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+#include <vtkSMPThreadLocal.h>
+#include <vtkSMPTools.h>
+
+#include "TetBVH.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// Bounding box and Morton code utilities.                                   //
+///////////////////////////////////////////////////////////////////////////////
+
+static void empty_box(BoundingBox & box)
+{
+  for (int d = 0; d < 3; ++d) {
+    box.lo[d] =  std::numeric_limits<double>::max();
+    box.hi[d] = -std::numeric_limits<double>::max();
+  }
+}
+
+static void grow_box(BoundingBox & box, const Vertex3d & v)
+{
+  box.lo[0] = std::min(box.lo[0], v.x);
+  box.lo[1] = std::min(box.lo[1], v.y);
+  box.lo[2] = std::min(box.lo[2], v.z);
+  box.hi[0] = std::max(box.hi[0], v.x);
+  box.hi[1] = std::max(box.hi[1], v.y);
+  box.hi[2] = std::max(box.hi[2], v.z);
+}
+
+static void merge_box(BoundingBox & box, const BoundingBox & other)
+{
+  for (int d = 0; d < 3; ++d) {
+    box.lo[d] = std::min(box.lo[d], other.lo[d]);
+    box.hi[d] = std::max(box.hi[d], other.hi[d]);
+  }
+}
+
+static bool box_contains(const BoundingBox & box, const Vertex3d & p)
+{
+  return p.x >= box.lo[0] && p.x <= box.hi[0]
+      && p.y >= box.lo[1] && p.y <= box.hi[1]
+      && p.z >= box.lo[2] && p.z <= box.hi[2];
+}
+
+// Spread the lower 10 bits of v so that there are two zero bits between
+// each of them.
+static uint32_t expand_bits(uint32_t v)
+{
+  v = (v * 0x00010001u) & 0xFF0000FFu;
+  v = (v * 0x00000101u) & 0x0F00F00Fu;
+  v = (v * 0x00000011u) & 0xC30C30C3u;
+  v = (v * 0x00000005u) & 0x49249249u;
+  return v;
+}
+
+uint32_t morton_code(const Vertex3d & p, const BoundingBox & box)
+{
+  double   q[3] = {p.x, p.y, p.z};
+  uint32_t c[3];
+
+  for (int d = 0; d < 3; ++d) {
+    double extent = box.hi[d] - box.lo[d];
+    double t      = (extent > 0.0) ? (q[d] - box.lo[d])/extent : 0.0;
+    // NOTE: non-finite points (or boxes) give NaN, which would survive the
+    //       clamp below, so they are put at the low corner.
+    if (std::isnan(t)) {
+      t = 0.0;
+    }
+    t    = std::min(std::max(t, 0.0), 1.0);
+    c[d] = (uint32_t)std::min(t*1024.0, 1023.0);
+  }
+
+  return expand_bits(c[0])*4 + expand_bits(c[1])*2 + expand_bits(c[2]);
+}
+
+/**
+ * Parallel reduction of the bounding box of a set of vertices.
+ */
+struct BoundsFunctor
+{
+  const VertexField3d            & vert;
+  vtkSMPThreadLocal<BoundingBox>   local;
+  BoundingBox                      result;
+
+  BoundsFunctor(const VertexField3d & v) : vert(v) {}
+
+  void Initialize()
+  {
+    empty_box(local.Local());
+  }
+
+  void operator() (vtkIdType begin, vtkIdType end)
+  {
+    BoundingBox & box = local.Local();
+    for (vtkIdType i = begin; i < end; ++i) {
+      grow_box(box, vert[i]);
+    }
+  }
+
+  void Reduce()
+  {
+    empty_box(result);
+    for (const BoundingBox & box : local) {
+      merge_box(result, box);
+    }
+  }
+};
+
+BoundingBox vertex_bounds(const VertexField3d & vert)
+{
+  BoundsFunctor bounds(vert);
+  vtkSMPTools::For(0, vert.size(), bounds);
+  return bounds.result;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Constructor                                                               //
+///////////////////////////////////////////////////////////////////////////////
+
+TetBVH::TetBVH(const VertexField3d & vert, const ConnectIndices4 & conn) :
+  mVert(vert), mNLeaves(1), mEps(0.0)
+{
+  vtkIdType ntet = conn.size();
+
+  // Bounds of the mesh, used to quantise Morton codes and as a length scale
+  // for the tolerance of point location.
+  BoundingBox bounds = vertex_bounds(vert);
+
+  double diag = 0.0;
+  for (int d = 0; d < 3; ++d) {
+    double extent = std::max(bounds.hi[d] - bounds.lo[d], 0.0);
+    diag += extent*extent;
+  }
+  mEps = 1E-9*sqrt(diag);
+
+  // Sort the tetrahedra along the Morton curve of their centroids.
+  std::vector< std::pair<uint32_t, vtkIdType> > codes(ntet);
+  vtkSMPTools::For(0, ntet, [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType t = begin; t < end; ++t) {
+      const Connect4 & c = conn[t];
+      Vertex3d centroid = (vert[c[0]] + vert[c[1]] + vert[c[2]] + vert[c[3]])/4.0;
+      codes[t] = std::make_pair(morton_code(centroid, bounds), t);
+    }
+  });
+  vtkSMPTools::Sort(codes.begin(), codes.end());
+
+  mTets.resize(ntet);
+  mTetIds.resize(ntet);
+  vtkSMPTools::For(0, ntet, [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType k = begin; k < end; ++k) {
+      mTetIds[k] = codes[k].second;
+      mTets[k]   = conn[codes[k].second];
+    }
+  });
+
+  // Leaf buckets, padded with empty boxes up to a power of two.
+  size_t nbuckets = (ntet + LeafSize - 1)/LeafSize;
+  while (mNLeaves < nbuckets) {
+    mNLeaves <<= 1;
+  }
+  mNodes.resize(2*mNLeaves);
+  empty_box(mNodes[0]);
+
+  vtkSMPTools::For(0, mNLeaves, [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType l = begin; l < end; ++l) {
+      BoundingBox & box = mNodes[mNLeaves + l];
+      empty_box(box);
+
+      size_t first = l*LeafSize;
+      size_t last  = std::min(first + LeafSize, mTets.size());
+      for (size_t k = first; k < last; ++k) {
+        for (int i = 0; i < 4; ++i) {
+          grow_box(box, mVert[mTets[k][i]]);
+        }
+      }
+
+      if (first < last) {
+        for (int d = 0; d < 3; ++d) {
+          box.lo[d] -= mEps;
+          box.hi[d] += mEps;
+        }
+      }
+    }
+  });
+
+  // Internal nodes, one level at a time from the leaves to the root.
+  for (size_t level = mNLeaves/2; level >= 1; level /= 2) {
+    vtkSMPTools::For(level, 2*level, [&](vtkIdType begin, vtkIdType end) {
+      for (vtkIdType i = begin; i < end; ++i) {
+        mNodes[i] = mNodes[2*i];
+        merge_box(mNodes[i], mNodes[2*i + 1]);
+      }
+    });
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Function locate()                                                         //
+///////////////////////////////////////////////////////////////////////////////
+
+vtkIdType TetBVH::locate(const Vertex3d & p, double bary[4]) const
+{
+  // The tree depth is at most log2(mNLeaves), so a small fixed stack will do.
+  size_t stack[64];
+  int    top = 0;
+
+  stack[top++] = 1;
+  while (top > 0) {
+    size_t node = stack[--top];
+
+    if (!box_contains(mNodes[node], p)) {
+      continue;
+    }
+
+    if (node >= mNLeaves) {
+      size_t first = (node - mNLeaves)*LeafSize;
+      size_t last  = std::min(first + LeafSize, mTets.size());
+      for (size_t k = first; k < last; ++k) {
+        if (inTet(k, p, bary)) {
+          return mTetIds[k];
+        }
+      }
+    } else {
+      stack[top++] = 2*node + 1;
+      stack[top++] = 2*node;
+    }
+  }
+
+  return -1;
+}
+
+void TetBVH::locate(
+    const Vertex3d * points,
+    size_t           npoints,
+    TetLocation    * loc) const
+{
+  std::vector< std::pair<uint32_t, size_t> > order(npoints);
+  vtkSMPTools::For(0, npoints, [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType i = begin; i < end; ++i) {
+      order[i] = std::make_pair(morton_code(points[i], bounds()), (size_t)i);
+    }
+  });
+  vtkSMPTools::Sort(order.begin(), order.end());
+
+  vtkSMPTools::For(0, npoints, [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType k = begin; k < end; ++k) {
+      size_t i = order[k].second;
+      loc[i].tet = locate(points[i], loc[i].bary);
+    }
+  });
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Function memoryBytes()                                                    //
+///////////////////////////////////////////////////////////////////////////////
+
+size_t TetBVH::memoryBytes() const
+{
+  return mTets.capacity()*sizeof(Connect4)
+       + mTetIds.capacity()*sizeof(vtkIdType)
+       + mNodes.capacity()*sizeof(BoundingBox);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Private functions.                                                        //
+///////////////////////////////////////////////////////////////////////////////
+
+bool TetBVH::inTet(size_t k, const Vertex3d & p, double bary[4]) const
+{
+  const Connect4 & c = mTets[k];
+
+  if (!barycentric(mVert[c[0]], mVert[c[1]], mVert[c[2]], mVert[c[3]],
+                   p, bary)) {
+    return false;
+  }
+
+  const double tol = -1E-10;
+  return bary[0] >= tol && bary[1] >= tol && bary[2] >= tol && bary[3] >= tol;
+}
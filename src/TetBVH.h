@@ -0,0 +1,124 @@
+/**
+ * \file   TetBVH.h
+ * \author L. Nagy
+ *
+ * MIT License
+ *
+ * Copyright (c) [2016] Lesleis Nagy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+
+#ifndef TET_BVH_H_
+#define TET_BVH_H_
+
+#include <vector>
+
+#include <vtkType.h>
+
+#include "Data.h"
+
+/**
+ * The result of locating a point in a tetrahedral mesh.
+ */
+struct TetLocation {
+  /// The index of the containing tetrahedron, -1 if the point is outside.
+  vtkIdType tet;
+  /// Barycentric coordinates of the point w.r.t. the tetrahedron vertices.
+  double    bary[4];
+};
+
+/**
+ * Axis aligned bounding box.
+ */
+struct BoundingBox {
+  /// Lower corner.
+  double lo[3];
+  /// Upper corner.
+  double hi[3];
+};
+
+/**
+ * \brief Bounding volume hierarchy over the tetrahedra of a mesh.
+ *
+ * Tetrahedra are sorted along a Morton (z-order) curve and grouped in to
+ * fixed size leaf buckets, the hierarchy is then an implicit complete binary
+ * tree over the buckets (node i has children 2i and 2i+1, the root is node
+ * 1) stored in a single flat array. Every stage of the build is parallel.
+ */
+class TetBVH
+{
+public:
+  /// The (maximum) number of tetrahedra in a leaf bucket.
+  static const size_t LeafSize = 8;
+
+  /**
+   * \brief Build the hierarchy, the vertices must outlive the hierarchy.
+   */
+  TetBVH(const VertexField3d & vert, const ConnectIndices4 & conn);
+
+  /**
+   * \brief Locate a single point.
+   *
+   * \param[in]  p    the point.
+   * \param[out] bary the barycentric coordinates of p in the containing
+   *                  tetrahedron.
+   *
+   * \return the index of the tetrahedron containing p, or -1.
+   */
+  vtkIdType locate(const Vertex3d & p, double bary[4]) const;
+
+  /**
+   * \brief Locate a batch of points in parallel, queries are processed in
+   *        Morton order so that neighbouring queries share tree paths.
+   *
+   * \param[in]  points  the points.
+   * \param[in]  npoints the number of points.
+   * \param[out] loc     the location of each point (npoints entries).
+   */
+  void locate(const Vertex3d * points, size_t npoints, TetLocation * loc) const;
+
+  /// The bounding box of the whole mesh.
+  const BoundingBox & bounds() const { return mNodes[1]; }
+
+  /// The approximate memory used by the hierarchy.
+  size_t memoryBytes() const;
+
+private:
+  const VertexField3d       & mVert;
+  ConnectIndices4             mTets;
+  std::vector<vtkIdType>      mTetIds;
+  std::vector<BoundingBox>    mNodes;
+  size_t                      mNLeaves;
+  double                      mEps;
+
+  bool inTet(size_t k, const Vertex3d & p, double bary[4]) const;
+};
+
+/**
+ * Compute a 30 bit Morton code for a point inside a bounding box.
+ */
+uint32_t morton_code(const Vertex3d & p, const BoundingBox & box);
+
+/**
+ * Compute the bounding box of a set of vertices (in parallel).
+ */
+BoundingBox vertex_bounds(const VertexField3d & vert);
+
+#endif  // TET_BVH_H_
@@ -0,0 +1,288 @@
+/**
+ * \file   TetGeometry.cpp
+ * \author L. Nagy
+ *
+ * MIT License
+ *
+ * Copyright (c) [2016] Lesleis Nagy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+
+#include <cmath>
+#include <numeric>
+
+#include <vtkSMPThreadLocal.h>
+#include <vtkSMPTools.h>
+
+#include "TetGeometry.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// Constructor                                                               //
+///////////////////////////////////////////////////////////////////////////////
+
+TetGeometry::TetGeometry(const VertexField3d & vert, const ConnectIndices4 & conn) :
+  mConn(conn),
+  mVolumes(conn.size()),
+  mGradients(conn.size()),
+  mNodalVolumes(vert.size(), 0.0),
+  mVolume(0.0),
+  mVertexTetOffsets(vert.size() + 1, 0),
+  mVertexTets(4*conn.size())
+{
+  // Volumes and shape function gradients, for edges e1, e2, e3 from vertex 0
+  // and det = e1.(e2 x e3) = 6V we have grad(phi_1) = (e2 x e3)/det etc.
+  vtkSMPTools::For(0, conn.size(), [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType t = begin; t < end; ++t) {
+      const Connect4 & c = conn[t];
+      Vector3d e1 = vert[c[1]] - vert[c[0]];
+      Vector3d e2 = vert[c[2]] - vert[c[0]];
+      Vector3d e3 = vert[c[3]] - vert[c[0]];
+
+      Vector3d n1 = cross(e2, e3);
+      Vector3d n2 = cross(e3, e1);
+      Vector3d n3 = cross(e1, e2);
+
+      double det = dot(e1, n1);
+      ShapeGradients & g = mGradients[t];
+      if (det == 0.0) {
+        // Degenerate tetrahedron, it contributes nothing.
+        mVolumes[t] = 0.0;
+        g.fill({.x = 0.0, .y = 0.0, .z = 0.0});
+        continue;
+      }
+
+      mVolumes[t] = fabs(det)/6.0;
+      g[1] = n1/det;
+      g[2] = n2/det;
+      g[3] = n3/det;
+      g[0] = (g[1] + g[2] + g[3])*(-1.0);
+    }
+  });
+
+  // Vertex to tetrahedron adjacency (compressed rows), a counting sort is
+  // linear and cheap next to the loops above so is done serially.
+  for (const Connect4 & c : conn) {
+    for (int k = 0; k < 4; ++k) {
+      mVertexTetOffsets[c[k] + 1]++;
+    }
+  }
+  for (size_t v = 0; v < vert.size(); ++v) {
+    mVertexTetOffsets[v + 1] += mVertexTetOffsets[v];
+  }
+  std::vector<vtkIdType> fill(mVertexTetOffsets.begin(), mVertexTetOffsets.end() - 1);
+  for (size_t t = 0; t < conn.size(); ++t) {
+    for (int k = 0; k < 4; ++k) {
+      mVertexTets[fill[conn[t][k]]++] = t;
+    }
+  }
+
+  // Lumped nodal volumes, gathered so that the result is deterministic.
+  vtkSMPTools::For(0, vert.size(), [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType v = begin; v < end; ++v) {
+      double vol = 0.0;
+      for (vtkIdType k = mVertexTetOffsets[v]; k < mVertexTetOffsets[v+1]; ++k) {
+        vol += mVolumes[mVertexTets[k]];
+      }
+      mNodalVolumes[v] = vol/4.0;
+    }
+  });
+
+  mVolume = std::accumulate(mVolumes.begin(), mVolumes.end(), 0.0);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Functions integrate() and volumeAverage()                                 //
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Parallel reduction of sum_v V_v f_v, per component. The inner loops are
+ * branch free over contiguous data so that they vectorise.
+ */
+struct IntegrateFunctor
+{
+  const double                             * w;
+  const double                             * f;
+  int                                        ncomp;
+  vtkSMPThreadLocal< std::vector<double> >   local;
+  std::vector<double>                        result;
+
+  IntegrateFunctor(const double * w, const double * f, int ncomp) :
+    w(w), f(f), ncomp(ncomp), local(std::vector<double>(ncomp, 0.0)),
+    result(ncomp, 0.0)
+  {}
+
+  // Thread locals are initialised from their exemplar.
+  void Initialize() {}
+
+  void operator() (vtkIdType begin, vtkIdType end)
+  {
+    std::vector<double> & sum = local.Local();
+    if (ncomp == 1) {
+      double s = 0.0;
+      for (vtkIdType v = begin; v < end; ++v) {
+        s += w[v]*f[v];
+      }
+      sum[0] += s;
+    } else if (ncomp == 3) {
+      double sx = 0.0, sy = 0.0, sz = 0.0;
+      for (vtkIdType v = begin; v < end; ++v) {
+        sx += w[v]*f[3*v];
+        sy += w[v]*f[3*v+1];
+        sz += w[v]*f[3*v+2];
+      }
+      sum[0] += sx;
+      sum[1] += sy;
+      sum[2] += sz;
+    } else {
+      for (vtkIdType v = begin; v < end; ++v) {
+        for (int d = 0; d < ncomp; ++d) {
+          sum[d] += w[v]*f[ncomp*v + d];
+        }
+      }
+    }
+  }
+
+  void Reduce()
+  {
+    std::fill(result.begin(), result.end(), 0.0);
+    for (const std::vector<double> & sum : local) {
+      for (int d = 0; d < ncomp; ++d) {
+        result[d] += sum[d];
+      }
+    }
+  }
+};
+
+void TetGeometry::integrate(const double * f, int ncomp, double * result) const
+{
+  IntegrateFunctor integral(mNodalVolumes.data(), f, ncomp);
+  vtkSMPTools::For(0, nvert(), integral);
+
+  std::copy(integral.result.begin(), integral.result.end(), result);
+}
+
+void TetGeometry::volumeAverage(const double * f, int ncomp, double * result) const
+{
+  integrate(f, ncomp, result);
+  for (int d = 0; d < ncomp; ++d) {
+    result[d] = mVolume > 0.0 ? result[d]/mVolume : 0.0;
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Function tetCurl()                                                        //
+///////////////////////////////////////////////////////////////////////////////
+
+void TetGeometry::tetCurl(const double * m, Vector3d * curl) const
+{
+  vtkSMPTools::For(0, mConn.size(), [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType t = begin; t < end; ++t) {
+      const Connect4       & c = mConn[t];
+      const ShapeGradients & g = mGradients[t];
+
+      Vector3d r = {.x = 0.0, .y = 0.0, .z = 0.0};
+      for (int k = 0; k < 4; ++k) {
+        const double * mk = m + 3*c[k];
+        r = r + cross(g[k], {.x = mk[0], .y = mk[1], .z = mk[2]});
+      }
+      curl[t] = r*mVolumes[t];
+    }
+  });
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Function tetDivergence()                                                  //
+///////////////////////////////////////////////////////////////////////////////
+
+void TetGeometry::tetDivergence(const double * m, double * div) const
+{
+  vtkSMPTools::For(0, mConn.size(), [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType t = begin; t < end; ++t) {
+      const Connect4       & c = mConn[t];
+      const ShapeGradients & g = mGradients[t];
+
+      double r = 0.0;
+      for (int k = 0; k < 4; ++k) {
+        const double * mk = m + 3*c[k];
+        r += g[k].x*mk[0] + g[k].y*mk[1] + g[k].z*mk[2];
+      }
+      div[t] = r*mVolumes[t];
+    }
+  });
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Function tetGradientNorm2()                                               //
+///////////////////////////////////////////////////////////////////////////////
+
+void TetGeometry::tetGradientNorm2(const double * m, double * g2) const
+{
+  vtkSMPTools::For(0, mConn.size(), [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType t = begin; t < end; ++t) {
+      const Connect4       & c = mConn[t];
+      const ShapeGradients & g = mGradients[t];
+
+      double r = 0.0;
+      for (int i = 0; i < 3; ++i) {
+        Vector3d row = {.x = 0.0, .y = 0.0, .z = 0.0};
+        for (int k = 0; k < 4; ++k) {
+          double mki = m[3*c[k]+i];
+          row.x += mki*g[k].x;
+          row.y += mki*g[k].y;
+          row.z += mki*g[k].z;
+        }
+        r += row.x*row.x + row.y*row.y + row.z*row.z;
+      }
+      g2[t] = r*mVolumes[t];
+    }
+  });
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Function nodalCurl()                                                      //
+///////////////////////////////////////////////////////////////////////////////
+
+void TetGeometry::nodalCurl(const double * m, double * curl) const
+{
+  std::vector<Vector3d> weighted(mConn.size());
+  tetCurl(m, weighted.data());
+
+  vtkSMPTools::For(0, nvert(), [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType v = begin; v < end; ++v) {
+      Vector3d r = gather(v, weighted.data());
+      curl[3*v]   = r.x;
+      curl[3*v+1] = r.y;
+      curl[3*v+2] = r.z;
+    }
+  });
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Function memoryBytes()                                                    //
+///////////////////////////////////////////////////////////////////////////////
+
+size_t TetGeometry::memoryBytes() const
+{
+  return mVolumes.capacity()*sizeof(double)
+       + mGradients.capacity()*sizeof(ShapeGradients)
+       + mNodalVolumes.capacity()*sizeof(double)
+       + mVertexTetOffsets.capacity()*sizeof(vtkIdType)
+       + mVertexTets.capacity()*sizeof(vtkIdType);
+}
@@ -0,0 +1,155 @@
+/**
+ * \file   TetGeometry.h
+ * \author L. Nagy
+ *
+ * MIT License
+ *
+ * Copyright (c) [2016] Lesleis Nagy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+
+#ifndef TET_GEOMETRY_H_
+#define TET_GEOMETRY_H_
+
+#include <array>
+#include <vector>
+
+#include <vtkType.h>
+
+#include "Data.h"
+
+/// The gradients of the four (P1) shape functions of a tetrahedron.
+typedef std::array<Vector3d, 4> ShapeGradients;
+
+/**
+ * \brief Geometric operators of a tetrahedral mesh.
+ *
+ * Tetrahedron volumes and (constant) P1 shape function gradients are
+ * computed once, as are lumped nodal volumes (a quarter of the volume of
+ * each tetrahedron sharing the vertex) and the vertex to tetrahedron
+ * adjacency. With these, differential operators of nodal fields are a
+ * parallel pass over tetrahedra followed by a parallel gather at vertices.
+ */
+class TetGeometry
+{
+public:
+  TetGeometry(const VertexField3d & vert, const ConnectIndices4 & conn);
+
+  size_t nvert() const { return mNodalVolumes.size(); }
+
+  size_t ntet() const { return mVolumes.size(); }
+
+  const ConnectIndices4 & connectivity() const { return mConn; }
+
+  /// The (unsigned) volume of each tetrahedron.
+  const std::vector<double> & volumes() const { return mVolumes; }
+
+  /// The shape function gradients of each tetrahedron.
+  const std::vector<ShapeGradients> & gradients() const { return mGradients; }
+
+  /// The lumped volume of each vertex.
+  const std::vector<double> & nodalVolumes() const { return mNodalVolumes; }
+
+  /// The total volume of the mesh.
+  double volume() const { return mVolume; }
+
+  /**
+   * \brief Integrate a nodal field over the mesh using the lumped nodal
+   *        volumes (a parallel reduction).
+   *
+   * \param[in]  f      the nodal field (ncomp components per vertex).
+   * \param[in]  ncomp  the number of components.
+   * \param[out] result the integral of each component (ncomp entries).
+   */
+  void integrate(const double * f, int ncomp, double * result) const;
+
+  /**
+   * \brief The volume weighted average of a nodal field, see integrate().
+   */
+  void volumeAverage(const double * f, int ncomp, double * result) const;
+
+  /**
+   * \brief Compute the volume weighted curl of a nodal vector field in each
+   *        tetrahedron, i.e. V_t * sum_a grad(phi_a) x m_a.
+   *
+   * \param[in]  m    the nodal field (3 components per vertex).
+   * \param[out] curl the weighted curl (ntet entries).
+   */
+  void tetCurl(const double * m, Vector3d * curl) const;
+
+  /**
+   * \brief Compute the volume weighted divergence of a nodal vector field in
+   *        each tetrahedron, i.e. V_t * sum_a grad(phi_a).m_a.
+   */
+  void tetDivergence(const double * m, double * div) const;
+
+  /**
+   * \brief Compute the volume weighted squared (Frobenius) norm of the
+   *        gradient of a nodal vector field in each tetrahedron, i.e.
+   *        V_t * |sum_a m_a grad(phi_a)^T|^2.
+   */
+  void tetGradientNorm2(const double * m, double * g2) const;
+
+  /**
+   * \brief Gather volume weighted per-tetrahedron values to vertex v, this
+   *        is the volume weighted average over the tetrahedra sharing v.
+   */
+  Vector3d gather(vtkIdType v, const Vector3d * weighted) const
+  {
+    Vector3d r = {.x = 0.0, .y = 0.0, .z = 0.0};
+    for (vtkIdType k = mVertexTetOffsets[v]; k < mVertexTetOffsets[v+1]; ++k) {
+      r = r + weighted[mVertexTets[k]];
+    }
+    // Tetrahedra sharing v have total volume 4x the lumped volume.
+    double vol = 4.0*mNodalVolumes[v];
+    return vol > 0.0 ? r/vol : r;
+  }
+
+  /// As above, for scalar per-tetrahedron values.
+  double gather(vtkIdType v, const double * weighted) const
+  {
+    double r = 0.0;
+    for (vtkIdType k = mVertexTetOffsets[v]; k < mVertexTetOffsets[v+1]; ++k) {
+      r += weighted[mVertexTets[k]];
+    }
+    double vol = 4.0*mNodalVolumes[v];
+    return vol > 0.0 ? r/vol : r;
+  }
+
+  /**
+   * \brief Compute the curl of a nodal vector field at the vertices, by
+   *        volume weighted recovery of the per-tetrahedron curl.
+   */
+  void nodalCurl(const double * m, double * curl) const;
+
+  /// The memory used by the operators.
+  size_t memoryBytes() const;
+
+private:
+  const ConnectIndices4        & mConn;
+  std::vector<double>            mVolumes;
+  std::vector<ShapeGradients>    mGradients;
+  std::vector<double>            mNodalVolumes;
+  double                         mVolume;
+  std::vector<vtkIdType>         mVertexTetOffsets;
+  std::vector<vtkIdType>         mVertexTets;
+};
+
+#endif  // TET_GEOMETRY_H_
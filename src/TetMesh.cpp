@@ -0,0 +1,445 @@
+/**
+ * \file   TetMesh.cpp
+ * \author L. Nagy
+ *
+ * MIT License
+ *
+ * Copyright (c) [2016] Lesleis Nagy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+
+#include <algorithm>
+#include <cstring>
+
+#include <vtkDoubleArray.h>
+#include <vtkIdTypeArray.h>
+#include <vtkSMPTools.h>
+
+#include "TetMesh.h"
+#include "DebugMacros.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// Registry of live meshes, keyed by mesh hash.                              //
+///////////////////////////////////////////////////////////////////////////////
+
+static std::mutex                                                sRegistryMutex;
+static std::unordered_multimap< size_t, std::weak_ptr<TetMesh> > sRegistry;
+
+///////////////////////////////////////////////////////////////////////////////
+// Function acquire()                                                        //
+///////////////////////////////////////////////////////////////////////////////
+
+std::shared_ptr<TetMesh> TetMesh::acquire(
+    const VertexField3d   & vert,
+    const ConnectIndices4 & conn)
+{
+  size_t hash = computeHash(vert, conn);
+
+  {
+    std::lock_guard<std::mutex> lock(sRegistryMutex);
+    if (std::shared_ptr<TetMesh> mesh = find(hash, vert, conn)) {
+      return mesh;
+    }
+  }
+
+  // The mesh is built outside the lock so that other loads are not blocked,
+  // another thread may have registered an equal mesh meanwhile.
+  std::shared_ptr<TetMesh> mesh = std::make_shared<TetMesh>(vert, conn, hash);
+
+  std::lock_guard<std::mutex> lock(sRegistryMutex);
+  if (std::shared_ptr<TetMesh> existing = find(hash, vert, conn)) {
+    return existing;
+  }
+  sRegistry.insert({hash, mesh});
+
+  return mesh;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Function find()                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+std::shared_ptr<TetMesh> TetMesh::find(
+    size_t                  hash,
+    const VertexField3d   & vert,
+    const ConnectIndices4 & conn)
+{
+  auto range = sRegistry.equal_range(hash);
+  for (auto it = range.first; it != range.second; ) {
+    std::shared_ptr<TetMesh> mesh = it->second.lock();
+    if (!mesh) {
+      // The mesh has died, prune the entry.
+      it = sRegistry.erase(it);
+      continue;
+    }
+    if (mesh->equals(vert, conn)) {
+      DEBUG("Sharing existing mesh with hash " << hash);
+      return mesh;
+    }
+    ++it;
+  }
+
+  return nullptr;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Constructor                                                               //
+///////////////////////////////////////////////////////////////////////////////
+
+TetMesh::TetMesh(
+    const VertexField3d   & vert,
+    const ConnectIndices4 & conn,
+    size_t                  hash) :
+  mVert(vert.begin(), vert.end()),
+  mConn(conn.begin(), conn.end()),
+  mHash(hash),
+  mBounds(vertex_bounds(mVert)),
+  mBuilt(0)
+{
+  // NOTE: mVert/mConn are constructed from iterators so that they allocate
+  //       from the default resource and not from the (per load) resource of
+  //       the input containers.
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Function bvh()                                                            //
+///////////////////////////////////////////////////////////////////////////////
+
+const TetBVH & TetMesh::bvh() const
+{
+  std::call_once(mBvhOnce, [this]() {
+    mBvh = std::make_unique<TetBVH>(mVert, mConn);
+    mBuilt.fetch_or(BUILT_BVH, std::memory_order_release);
+  });
+
+  return *mBvh;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Function geometry()                                                       //
+///////////////////////////////////////////////////////////////////////////////
+
+const TetGeometry & TetMesh::geometry() const
+{
+  std::call_once(mGeometryOnce, [this]() {
+    mGeometry = std::make_unique<TetGeometry>(mVert, mConn);
+    mBuilt.fetch_or(BUILT_GEOMETRY, std::memory_order_release);
+  });
+
+  return *mGeometry;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Function boundary()                                                       //
+///////////////////////////////////////////////////////////////////////////////
+
+const BoundarySurface & TetMesh::boundary() const
+{
+  std::call_once(mBoundaryOnce, [this]() {
+    mBoundary = std::make_unique<BoundarySurface>(mVert, mConn);
+    mBuilt.fetch_or(BUILT_BOUNDARY, std::memory_order_release);
+  });
+
+  return *mBoundary;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Functions points() and cells()                                            //
+///////////////////////////////////////////////////////////////////////////////
+
+vtkSmartPointer<vtkPoints> TetMesh::points() const
+{
+  std::call_once(mVtkOnce, [this]() {
+    buildVtk();
+    mBuilt.fetch_or(BUILT_VTK, std::memory_order_release);
+  });
+
+  return mPoints;
+}
+
+vtkSmartPointer<vtkCellArray> TetMesh::cells() const
+{
+  std::call_once(mVtkOnce, [this]() {
+    buildVtk();
+    mBuilt.fetch_or(BUILT_VTK, std::memory_order_release);
+  });
+
+  return mCells;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Function surface()                                                        //
+///////////////////////////////////////////////////////////////////////////////
+
+vtkSmartPointer<vtkPolyData> TetMesh::surface() const
+{
+  std::call_once(mSurfaceOnce, [this]() {
+    const ConnectIndices3 & faces = boundary().faces();
+    vtkIdType               nface = faces.size();
+
+    vtkSmartPointer<vtkIdTypeArray> offsets = vtkSmartPointer<vtkIdTypeArray>::New();
+    offsets->SetNumberOfValues(nface + 1);
+    vtkSmartPointer<vtkIdTypeArray> connectivity = vtkSmartPointer<vtkIdTypeArray>::New();
+    connectivity->SetNumberOfValues(3*nface);
+    vtkIdType * o = offsets->GetPointer(0);
+    vtkIdType * c = connectivity->GetPointer(0);
+
+    vtkSMPTools::For(0, nface, [&](vtkIdType begin, vtkIdType end) {
+      for (vtkIdType f = begin; f < end; ++f) {
+        o[f] = 3*f;
+        for (int k = 0; k < 3; ++k) {
+          c[3*f+k] = faces[f][k];
+        }
+      }
+    });
+    o[nface] = 3*nface;
+
+    vtkSmartPointer<vtkCellArray> polys = vtkSmartPointer<vtkCellArray>::New();
+    polys->SetData(offsets, connectivity);
+
+    // NOTE: the points are those of the whole mesh, interior points are
+    //       simply not referenced.
+    mSurface = vtkSmartPointer<vtkPolyData>::New();
+    mSurface->SetPoints(points());
+    mSurface->SetPolys(polys);
+    mBuilt.fetch_or(BUILT_SURFACE, std::memory_order_release);
+  });
+
+  return mSurface;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Function resampler()                                                      //
+///////////////////////////////////////////////////////////////////////////////
+
+std::shared_ptr<const GridResampler> TetMesh::resampler(
+    const UniformGrid & grid) const
+{
+  std::lock_guard<std::mutex> lock(mResamplerMutex);
+
+  for (auto it = mResamplers.begin(); it != mResamplers.end(); ++it) {
+    if ((*it)->grid() == grid) {
+      std::rotate(mResamplers.begin(), it, it + 1);
+      return mResamplers.front();
+    }
+  }
+
+  auto r = std::make_shared<const GridResampler>(mVert, mConn, grid);
+  mResamplers.insert(mResamplers.begin(), r);
+  if (mResamplers.size() > Resamplers) {
+    mResamplers.pop_back();
+  }
+
+  return r;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Function glyphSample()                                                    //
+///////////////////////////////////////////////////////////////////////////////
+
+std::shared_ptr<const std::vector<vtkIdType>> TetMesh::glyphSample(
+    size_t target, bool surfaceOnly) const
+{
+  std::lock_guard<std::mutex> lock(mGlyphSampleMutex);
+
+  for (auto it = mGlyphSamples.begin(); it != mGlyphSamples.end(); ++it) {
+    if (it->first.first == target && it->first.second == surfaceOnly) {
+      std::rotate(mGlyphSamples.begin(), it, it + 1);
+      return mGlyphSamples.front().second;
+    }
+  }
+
+  auto ids = std::make_shared<std::vector<vtkIdType>>();
+  if (surfaceOnly) {
+    const std::vector<vtkIdType> & candidates = boundary().vertices();
+    glyph_sample(mVert, candidates.data(), candidates.size(), target, NULL, *ids);
+  } else {
+    glyph_sample(mVert, target, NULL, *ids);
+  }
+  mGlyphSamples.insert(mGlyphSamples.begin(), {{target, surfaceOnly}, ids});
+  if (mGlyphSamples.size() > GlyphSamples) {
+    mGlyphSamples.pop_back();
+  }
+
+  DEBUG("Glyph sample of " << ids->size() << " vertices (target " << target << ")");
+
+  return ids;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Function planeSlicer()                                                    //
+///////////////////////////////////////////////////////////////////////////////
+
+// A slicer is reused for normals within 3 degrees of its own.
+static const double sSlicerCos = 0.99862953475457387;
+
+std::shared_ptr<const PlaneSlicer> TetMesh::planeSlicer(
+    const Vector3d & normal) const
+{
+  Vector3d n = normal/norm(normal);
+
+  std::lock_guard<std::mutex> lock(mPlaneSlicerMutex);
+
+  // NOTE: dragging a plane keeps its normal, rotating it only tilts it a
+  //       little per event, which a slicer handles (exactly) at some cost.
+  for (auto it = mPlaneSlicers.begin(); it != mPlaneSlicers.end(); ++it) {
+    if (dot((*it)->normal(), n) >= sSlicerCos) {
+      std::rotate(mPlaneSlicers.begin(), it, it + 1);
+      return mPlaneSlicers.front();
+    }
+  }
+
+  auto s = std::make_shared<const PlaneSlicer>(mVert, mConn, n);
+  mPlaneSlicers.insert(mPlaneSlicers.begin(), s);
+  if (mPlaneSlicers.size() > PlaneSlicers) {
+    mPlaneSlicers.pop_back();
+  }
+
+  return s;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Function memoryBytes()                                                    //
+///////////////////////////////////////////////////////////////////////////////
+
+size_t TetMesh::memoryBytes() const
+{
+  size_t bytes = mVert.capacity()*sizeof(Vertex3d)
+               + mConn.capacity()*sizeof(Connect4);
+
+  // NOTE: only products whose builders have finished are read, one being
+  //       built concurrently is reported by a later call.
+  unsigned built = mBuilt.load(std::memory_order_acquire);
+  if (built & BUILT_BVH) {
+    bytes += mBvh->memoryBytes();
+  }
+  if (built & BUILT_GEOMETRY) {
+    bytes += mGeometry->memoryBytes();
+  }
+  if (built & BUILT_BOUNDARY) {
+    bytes += mBoundary->memoryBytes();
+  }
+  if (built & BUILT_VTK) {
+    // NOTE: VTK reports sizes in KiB.
+    bytes += mPoints->GetActualMemorySize()*1024;
+    bytes += mCells->GetActualMemorySize()*1024;
+  }
+  if (built & BUILT_SURFACE) {
+    bytes += mSurface->GetPolys()->GetActualMemorySize()*1024;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mResamplerMutex);
+    for (auto r : mResamplers) {
+      bytes += r->memoryBytes();
+    }
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mGlyphSampleMutex);
+    for (auto s : mGlyphSamples) {
+      bytes += s.second->capacity()*sizeof(vtkIdType);
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(mPlaneSlicerMutex);
+  for (auto s : mPlaneSlicers) {
+    bytes += s->memoryBytes();
+  }
+
+  return bytes;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Private functions.                                                        //
+///////////////////////////////////////////////////////////////////////////////
+
+bool TetMesh::equals(
+    const VertexField3d   & vert,
+    const ConnectIndices4 & conn) const
+{
+  if (vert.size() != mVert.size() || conn.size() != mConn.size()) {
+    return false;
+  }
+
+  return memcmp(vert.data(), mVert.data(), sizeof(Vertex3d)*vert.size()) == 0
+      && memcmp(conn.data(), mConn.data(), sizeof(Connect4)*conn.size()) == 0;
+}
+
+void TetMesh::buildVtk() const
+{
+  vtkIdType nvert = mVert.size();
+  vtkIdType ntet  = mConn.size();
+
+  mPoints = vtkSmartPointer<vtkPoints>::New();
+  mPoints->SetDataTypeToDouble();
+  mPoints->SetNumberOfPoints(nvert);
+  double * p = vtkDoubleArray::SafeDownCast(mPoints->GetData())->GetPointer(0);
+
+  vtkSmartPointer<vtkIdTypeArray> offsets = vtkSmartPointer<vtkIdTypeArray>::New();
+  offsets->SetNumberOfValues(ntet + 1);
+  vtkSmartPointer<vtkIdTypeArray> connectivity = vtkSmartPointer<vtkIdTypeArray>::New();
+  connectivity->SetNumberOfValues(4*ntet);
+  vtkIdType * o = offsets->GetPointer(0);
+  vtkIdType * c = connectivity->GetPointer(0);
+
+  vtkSMPTools::For(0, nvert, [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType i = begin; i < end; ++i) {
+      p[3*i]   = mVert[i].x;
+      p[3*i+1] = mVert[i].y;
+      p[3*i+2] = mVert[i].z;
+    }
+  });
+
+  vtkSMPTools::For(0, ntet, [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType t = begin; t < end; ++t) {
+      o[t] = 4*t;
+      for (int k = 0; k < 4; ++k) {
+        c[4*t+k] = mConn[t][k];
+      }
+    }
+  });
+  o[ntet] = 4*ntet;
+
+  mCells = vtkSmartPointer<vtkCellArray>::New();
+  mCells->SetData(offsets, connectivity);
+}
+
+size_t TetMesh::computeHash(
+    const VertexField3d   & vert,
+    const ConnectIndices4 & conn)
+{
+  uint64_t seed = vert.size()*0x9e3779b97f4a7c15ULL + conn.size();
+
+  for (const Vertex3d & v : vert) {
+    uint64_t bits[3];
+    memcpy(bits, &v, sizeof(bits));
+    seed = mix_key(seed ^ bits[0]);
+    seed = mix_key(seed ^ bits[1]);
+    seed = mix_key(seed ^ bits[2]);
+  }
+
+  for (const Connect4 & c : conn) {
+    seed = mix_key(seed ^ (((uint64_t)c[0] << 32) | c[1]));
+    seed = mix_key(seed ^ (((uint64_t)c[2] << 32) | c[3]));
+  }
+
+  return (size_t)seed;
+}
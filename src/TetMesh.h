@@ -0,0 +1,245 @@
+/**
+ * \file   TetMesh.h
+ * \author L. Nagy
+ *
+ * MIT License
+ *
+ * Copyright (c) [2016] Lesleis Nagy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+
+#ifndef TET_MESH_H_
+#define TET_MESH_H_
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <vtkCellArray.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+
+#include "BoundarySurface.h"
+#include "Data.h"
+#include "GlyphSampling.h"
+#include "GridResampler.h"
+#include "PlaneSlicer.h"
+#include "TetBVH.h"
+#include "TetGeometry.h"
+
+/**
+ * \brief An immutable tetrahedral mesh, shared by all models defined on it.
+ *
+ * Models in a directory are (almost always) defined on the same mesh, so
+ * meshes are obtained through acquire() which returns an existing mesh if
+ * one with identical vertices and connectivity is still alive. Products
+ * that depend only on the mesh (e.g. the point location index, geometric
+ * operators, the boundary surface and VTK points/cells) are built lazily,
+ * once, and then shared by every model on the mesh.
+ */
+class TetMesh
+{
+public:
+  /// The number of resamplers (i.e. target grids) kept.
+  static const size_t Resamplers = 4;
+
+  /// The number of plane slicers (i.e. plane orientations) kept.
+  static const size_t PlaneSlicers = 4;
+
+  /// The number of glyph samples (i.e. targets) kept.
+  static const size_t GlyphSamples = 8;
+
+  /**
+   * \brief Return the mesh with the given vertices and connectivity, this is
+   *        either an existing (live) mesh or a newly created one.
+   *
+   * \param[in] vert the mesh vertices.
+   * \param[in] conn the mesh tetrahedra (zero indexed).
+   *
+   * \return a shared mesh.
+   */
+  static std::shared_ptr<TetMesh> acquire(
+      const VertexField3d   & vert,
+      const ConnectIndices4 & conn);
+
+  /**
+   * \brief Build a mesh, see acquire().
+   *
+   * \param[in] vert the mesh vertices.
+   * \param[in] conn the mesh tetrahedra (zero indexed).
+   * \param[in] hash the hash of the vertices and connectivity.
+   */
+  TetMesh(
+      const VertexField3d   & vert,
+      const ConnectIndices4 & conn,
+      size_t                  hash);
+
+  TetMesh(const TetMesh &) = delete;
+  TetMesh & operator= (const TetMesh &) = delete;
+
+  size_t nvert() const { return mVert.size(); }
+
+  size_t ntet() const { return mConn.size(); }
+
+  const VertexField3d & vertices() const { return mVert; }
+
+  const ConnectIndices4 & connectivity() const { return mConn; }
+
+  /// A hash of the vertices and connectivity.
+  size_t hash() const { return mHash; }
+
+  /// The bounding box of the vertices.
+  const BoundingBox & bounds() const { return mBounds; }
+
+  /**
+   * \brief Return the point location index, this is built on first request.
+   */
+  const TetBVH & bvh() const;
+
+  /**
+   * \brief Return the geometric operators (volumes, shape function gradients,
+   *        lumped nodal volumes), these are built on first request.
+   */
+  const TetGeometry & geometry() const;
+
+  /**
+   * \brief Return the boundary surface, this is built on first request.
+   */
+  const BoundarySurface & boundary() const;
+
+  /**
+   * \brief Return the VTK points of the mesh, shared by the grids of every
+   *        model on the mesh. Built on first request.
+   */
+  vtkSmartPointer<vtkPoints> points() const;
+
+  /**
+   * \brief Return the VTK (tetrahedron) cells of the mesh, shared by the
+   *        grids of every model on the mesh. Built on first request.
+   */
+  vtkSmartPointer<vtkCellArray> cells() const;
+
+  /**
+   * \brief Return the boundary surface as VTK triangles on the points of
+   *        the mesh, shared by every model on the mesh. Built on first
+   *        request.
+   */
+  vtkSmartPointer<vtkPolyData> surface() const;
+
+  /**
+   * \brief Return the (cached) resampler on to the given uniform grid, this
+   *        is built on first request for each distinct grid. Only the most
+   *        recently requested Resamplers grids are kept.
+   */
+  std::shared_ptr<const GridResampler> resampler(const UniformGrid & grid) const;
+
+  /**
+   * \brief Return the (cached) spatially uniform subset of about target
+   *        vertices at which to draw glyphs, see glyph_sample(). This is
+   *        built on first request for each distinct target, only the most
+   *        recently requested GlyphSamples targets are kept.
+   *
+   * \param[in] target      the number of vertices, zero for all of them.
+   * \param[in] surfaceOnly only pick vertices on the boundary surface.
+   */
+  std::shared_ptr<const std::vector<vtkIdType>> glyphSample(
+      size_t target, bool surfaceOnly = false) const;
+
+  /**
+   * \brief Return the (cached) slicer for planes with about the given
+   *        normal (within a few degrees), this is built on first request for
+   *        each orientation. Only the most recently requested PlaneSlicers
+   *        orientations are kept.
+   */
+  std::shared_ptr<const PlaneSlicer> planeSlicer(const Vector3d & normal) const;
+
+  /**
+   * \brief The memory used by the mesh and any products built so far.
+   */
+  size_t memoryBytes() const;
+
+private:
+  VertexField3d                   mVert;
+  ConnectIndices4                 mConn;
+  size_t                          mHash;
+  BoundingBox                     mBounds;
+
+  /// The once-built products whose construction has completed.
+  enum Built {
+    BUILT_BVH      = 1,
+    BUILT_GEOMETRY = 2,
+    BUILT_BOUNDARY = 4,
+    BUILT_VTK      = 8,
+    BUILT_SURFACE  = 16
+  };
+  /// Built flags, published (release) after each product is written so that
+  /// memoryBytes() can read products without racing their builders.
+  mutable std::atomic<unsigned>   mBuilt;
+
+  mutable std::once_flag          mBvhOnce;
+  mutable std::unique_ptr<TetBVH> mBvh;
+
+  mutable std::once_flag                mGeometryOnce;
+  mutable std::unique_ptr<TetGeometry>  mGeometry;
+
+  mutable std::once_flag                   mBoundaryOnce;
+  mutable std::unique_ptr<BoundarySurface> mBoundary;
+
+  mutable std::once_flag                mVtkOnce;
+  mutable vtkSmartPointer<vtkPoints>    mPoints;
+  mutable vtkSmartPointer<vtkCellArray> mCells;
+
+  mutable std::once_flag                mSurfaceOnce;
+  mutable vtkSmartPointer<vtkPolyData>  mSurface;
+
+  /// Most recently requested first.
+  mutable std::mutex                                          mResamplerMutex;
+  mutable std::vector< std::shared_ptr<const GridResampler> > mResamplers;
+
+  /// Most recently requested first.
+  mutable std::mutex                                          mGlyphSampleMutex;
+  mutable std::vector< std::pair< std::pair<size_t, bool>,
+      std::shared_ptr<const std::vector<vtkIdType>> > >       mGlyphSamples;
+
+  /// Most recently requested first.
+  mutable std::mutex                                          mPlaneSlicerMutex;
+  mutable std::vector< std::shared_ptr<const PlaneSlicer> >   mPlaneSlicers;
+
+  bool equals(const VertexField3d & vert, const ConnectIndices4 & conn) const;
+
+  void buildVtk() const;
+
+  static size_t computeHash(
+      const VertexField3d   & vert,
+      const ConnectIndices4 & conn);
+
+  /// Find a live registered mesh equal to vert/conn, the registry must be
+  /// locked.
+  static std::shared_ptr<TetMesh> find(
+      size_t                  hash,
+      const VertexField3d   & vert,
+      const ConnectIndices4 & conn);
+};
+
+#endif  // TET_MESH_H_
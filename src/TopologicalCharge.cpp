@@ -0,0 +1,170 @@
+/**
+ * \file   TopologicalCharge.cpp
+ * \author L. Nagy
+ *
+ * MIT License
+ *
+ * Copyright (c) [2016] Lesleis Nagy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+
+#include <cmath>
+
+#include <vtkSMPTools.h>
+
+#include "TopologicalCharge.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// Function topological_charge()                                             //
+///////////////////////////////////////////////////////////////////////////////
+
+void topological_charge(
+    const BoundarySurface & surface,
+    const double          * m,
+    double                * q)
+{
+  const ConnectIndices3 & faces = surface.faces();
+
+  vtkSMPTools::For(0, surface.nface(), [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType f = begin; f < end; ++f) {
+      Vector3d mk[3];
+      for (int k = 0; k < 3; ++k) {
+        const double * p = m + 3*faces[f][k];
+        mk[k] = cnormalize({.x = p[0], .y = p[1], .z = p[2]});
+      }
+
+      // tan(omega/2) = m1.(m2 x m3) / (1 + m1.m2 + m2.m3 + m3.m1)
+      double num = dot(mk[0], cross(mk[1], mk[2]));
+      double den = 1.0 + dot(mk[0], mk[1]) + dot(mk[1], mk[2]) + dot(mk[2], mk[0]);
+
+      q[f] = 2.0*atan2(num, den)/(4.0*M_PI);
+    }
+  });
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Function vortex_cores()                                                   //
+///////////////////////////////////////////////////////////////////////////////
+
+std::vector<VortexCore> vortex_cores(
+    const BoundarySurface & surface,
+    const VertexField3d   & vert,
+    const double          * m)
+{
+  const ConnectIndices3        & faces   = surface.faces();
+  const std::vector<Vector3d>  & normals = surface.normals();
+  const std::vector<double>    & areas   = surface.areas();
+  size_t nface = surface.nface();
+
+  // The winding number of the in-plane magnetisation around each face.
+  std::vector<int> winding(nface);
+  vtkSMPTools::For(0, nface, [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType f = begin; f < end; ++f) {
+      const Connect3 & face = faces[f];
+      const Vector3d & n    = normals[f];
+
+      // A right handed in-plane frame (e1, e2, n).
+      Vector3d e1 = cnormalize(vert[face[1]] - vert[face[0]]);
+      Vector3d e2 = cross(n, e1);
+
+      double theta[3];
+      bool   defined = true;
+      for (int k = 0; k < 3; ++k) {
+        const double * p = m + 3*face[k];
+        Vector3d mk = {.x = p[0], .y = p[1], .z = p[2]};
+        double u = dot(mk, e1), v = dot(mk, e2);
+        if (u*u + v*v < 1E-24) {
+          defined = false;
+          break;
+        }
+        theta[k] = atan2(v, u);
+      }
+      if (!defined) {
+        winding[f] = 0;
+        continue;
+      }
+
+      double turn = 0.0;
+      for (int k = 0; k < 3; ++k) {
+        double d = theta[(k+1)%3] - theta[k];
+        turn += d - 2.0*M_PI*round(d/(2.0*M_PI));
+      }
+      winding[f] = (int)lround(turn/(2.0*M_PI));
+    }
+  });
+
+  // Merge neighbouring core faces (a core near an edge or vertex may be
+  // seen by more than one face), cores are accumulated at their first face.
+  const std::vector< std::array<vtkIdType, 3> > & neighbours = surface.neighbours();
+
+  std::vector<vtkIdType> core(nface, -1);
+  std::vector<VortexCore> cores;
+  std::vector<vtkIdType>  stack;
+  for (size_t f = 0; f < nface; ++f) {
+    if (winding[f] == 0 || core[f] >= 0) {
+      continue;
+    }
+
+    vtkIdType c = cores.size();
+    Vertex3d  centre = {.x = 0.0, .y = 0.0, .z = 0.0};
+    double    a = 0.0, mn = 0.0;
+    int       w = 0;
+
+    core[f] = c;
+    stack.push_back(f);
+    while (!stack.empty()) {
+      vtkIdType g = stack.back();
+      stack.pop_back();
+
+      const Connect3 & face = faces[g];
+      Vertex3d centroid = (vert[face[0]] + vert[face[1]] + vert[face[2]])/3.0;
+      centre = centre + areas[g]*centroid;
+      a += areas[g];
+      w += winding[g];
+      for (int k = 0; k < 3; ++k) {
+        const double * p = m + 3*face[k];
+        mn += areas[g]*(p[0]*normals[g].x + p[1]*normals[g].y + p[2]*normals[g].z);
+      }
+
+      for (vtkIdType h : neighbours[g]) {
+        if (h >= 0 && winding[h] != 0 && core[h] < 0) {
+          core[h] = c;
+          stack.push_back(h);
+        }
+      }
+    }
+
+    // NOTE: the windings of a cluster may cancel (e.g. a vortex/antivortex
+    //       pair closer than the mesh spacing), in which case there is no
+    //       core.
+    if (w == 0) {
+      continue;
+    }
+
+    VortexCore vc;
+    vc.position = centre/a;
+    vc.winding  = w;
+    vc.polarity = mn >= 0.0 ? 1 : -1;
+    vc.patch    = surface.patches()[f];
+    cores.push_back(vc);
+  }
+
+  return cores;
+}
@@ -0,0 +1,85 @@
+/**
+ * \file   TopologicalCharge.h
+ * \author L. Nagy
+ *
+ * MIT License
+ *
+ * Copyright (c) [2016] Lesleis Nagy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+
+#ifndef TOPOLOGICAL_CHARGE_H_
+#define TOPOLOGICAL_CHARGE_H_
+
+#include <vector>
+
+#include "BoundarySurface.h"
+#include "Data.h"
+
+/**
+ * A vortex core, i.e. a point at which a core pierces the boundary surface.
+ */
+struct VortexCore {
+  /// The (area weighted) centre of the faces through which the core passes.
+  Vertex3d  position;
+  /// The winding number of the in-plane magnetisation around the core.
+  int       winding;
+  /// The sign of m.n at the core, +1 if the core points out of the surface.
+  int       polarity;
+  /// The surface patch on which the core lies.
+  vtkIdType patch;
+};
+
+/**
+ * \brief Compute the topological charge of each boundary face.
+ *
+ * The charge of a face is the signed solid angle, divided by 4 pi, of the
+ * spherical triangle spanned by the unit magnetisation at its vertices
+ * (Berg & Luscher), so the sum over a closed surface is the (integer)
+ * winding number of m over the surface. Evaluated in parallel.
+ *
+ * \param[in]  surface the boundary surface.
+ * \param[in]  m       the magnetisation (3 components per vertex).
+ * \param[out] q       the charge of each face (surface.nface() entries).
+ */
+void topological_charge(
+    const BoundarySurface & surface,
+    const double          * m,
+    double                * q);
+
+/**
+ * \brief Find the points at which vortex cores pierce the boundary surface.
+ *
+ * The magnetisation at the vertices of each face is projected on to the face
+ * and a core passes through the face if the projection winds around it
+ * (tested in parallel). Neighbouring core faces are merged in to one core.
+ *
+ * \param[in] surface the boundary surface.
+ * \param[in] vert    the mesh vertices.
+ * \param[in] m       the magnetisation (3 components per vertex).
+ *
+ * \return the cores, in order of their first face.
+ */
+std::vector<VortexCore> vortex_cores(
+    const BoundarySurface & surface,
+    const VertexField3d   & vert,
+    const double          * m);
+
+#endif  // TOPOLOGICAL_CHARGE_H_
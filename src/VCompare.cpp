@@ -38,6 +38,9 @@ VCompare::VCompare() :
 {
   this->setupUi(this);
 
+  mMemoryStatus = new QLabel(this);
+  statusbar->addPermanentWidget(mMemoryStatus);
+
   // Left VTK renderer.
   leftRenderer = vtkSmartPointer<vtkRenderer>::New();
   // Add the renderer to QT's VTK renderer.
@@ -79,6 +82,18 @@ VCompare::VCompare() :
   mRightMarkerWidget->SetViewport(0.0, 0.0, 0.2, 0.2);
   mRightMarkerWidget->SetEnabled(1);
   mRightMarkerWidget->InteractiveOn();
+
+  // Coarse arrows while the camera is moving.
+  mLeftInteractionCallback = setInteractionLevelOfDetail(
+      leftRenderer->GetRenderWindow()->GetInteractor(), &mLeftFields);
+  mRightInteractionCallback = setInteractionLevelOfDetail(
+      rightRenderer->GetRenderWindow()->GetInteractor(), &mRightFields);
+
+  // Slice planes, enabled with the slice toggle buttons.
+  mLeftSlicePlaneWidget = newSlicePlaneWidget(
+      leftRenderer->GetRenderWindow()->GetInteractor(), &mLeftFields);
+  mRightSlicePlaneWidget = newSlicePlaneWidget(
+      rightRenderer->GetRenderWindow()->GetInteractor(), &mRightFields);
   
   // Add default actors to geometry.
   leftRenderer->AddActor(geometryActor);
@@ -171,9 +186,69 @@ VCompare::VCompare() :
   connect(mRightToggleIsosurfaceButton , SIGNAL(clicked()),
           this                         , SLOT(slotRightToggleIsosurfaceButtonClicked()));
 
+  connect(mLeftToggleCoreLinesButton   , SIGNAL(clicked()),
+          this                         , SLOT(slotLeftToggleCoreLinesButtonClicked()));
+
+  connect(mRightToggleCoreLinesButton  , SIGNAL(clicked()),
+          this                         , SLOT(slotRightToggleCoreLinesButtonClicked()));
+
+  connect(mLeftToggleSurfaceButton     , SIGNAL(clicked()),
+          this                         , SLOT(slotLeftToggleSurfaceButtonClicked()));
+
+  connect(mRightToggleSurfaceButton    , SIGNAL(clicked()),
+          this                         , SLOT(slotRightToggleSurfaceButtonClicked()));
+
+  connect(mLeftToggleSliceButton       , SIGNAL(clicked()),
+          this                         , SLOT(slotLeftToggleSliceButtonClicked()));
+
+  connect(mRightToggleSliceButton      , SIGNAL(clicked()),
+          this                         , SLOT(slotRightToggleSliceButtonClicked()));
+
   connect(mArrowScale                  , SIGNAL(editingFinished()),
           this                         , SLOT(slotArrowScaleChanged()));
 
+  connect(mArrowCount                  , SIGNAL(editingFinished()),
+          this                         , SLOT(slotArrowCountChanged()));
+
+  connect(mArrowAdaptive               , SIGNAL(toggled(bool)),
+          this                         , SLOT(slotArrowCountChanged()));
+
+  connect(mColourBy                    , SIGNAL(currentIndexChanged(int)),
+          this                         , SLOT(slotColourByChanged(int)));
+
+  connect(mIsovalue                    , SIGNAL(valueChanged(int)),
+          this                         , SLOT(slotIsovalueChanged(int)));
+
+  connect(mContourBy                   , SIGNAL(currentIndexChanged(int)),
+          this                         , SLOT(slotContourByChanged(int)));
+
+  connect(mExpression                  , SIGNAL(returnPressed()),
+          this                         , SLOT(slotExpressionEntered()));
+
+  //---------------------------------------------------------------------------
+  // Colour by options (display text, point array name) and menus.
+  //---------------------------------------------------------------------------
+  mColourBy->blockSignals(true);
+  mColourBy->addItem("Helicity",                   "Helicity");
+  mColourBy->addItem("Energy density",             "EnergyDensity");
+  mColourBy->addItem("Exchange energy density",    "ExchangeEnergyDensity");
+  mColourBy->addItem("Anisotropy energy density",  "AnisotropyEnergyDensity");
+  mColourBy->addItem("Zeeman energy density",      "ZeemanEnergyDensity");
+  mColourBy->addItem("Volume charge",              "VolumeCharge");
+  mColourBy->addItem("Surface charge",             "SurfaceCharge");
+  mColourBy->addItem("Topological charge density", "TopologicalChargeDensity");
+  mColourBy->addItem("Expression",                 "Expression");
+  mColourBy->blockSignals(false);
+
+  mContourBy->blockSignals(true);
+  mContourBy->addItem("Helicity",   "Helicity");
+  mContourBy->addItem("Expression", "Expression");
+  mContourBy->blockSignals(false);
+
+  QMenu * analysisMenu = menubar->addMenu("Analysis");
+  analysisMenu->addAction("Material parameters...",
+                          this, SLOT(slotMaterialParametersTriggered()));
+
   connect(mRevertStartEndButton        , SIGNAL(clicked()),
           this                         , SLOT(slotRevertStartEndButtonClicked()));
 
@@ -565,6 +640,66 @@ void VCompare::slotRightToggleIsosurfaceButtonClicked()
   mDisplayVTKRight->update();
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// [SLOT] slotLeftToggleCoreLinesButtonClicked()                             //
+///////////////////////////////////////////////////////////////////////////////
+
+void VCompare::slotLeftToggleCoreLinesButtonClicked()
+{
+  mLeftFields.toggleCoreLines();
+  mDisplayVTKLeft->update();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// [SLOT] slotRightToggleCoreLinesButtonClicked()                            //
+///////////////////////////////////////////////////////////////////////////////
+
+void VCompare::slotRightToggleCoreLinesButtonClicked()
+{
+  mRightFields.toggleCoreLines();
+  mDisplayVTKRight->update();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// [SLOT] slotLeftToggleSurfaceButtonClicked()                               //
+///////////////////////////////////////////////////////////////////////////////
+
+void VCompare::slotLeftToggleSurfaceButtonClicked()
+{
+  mLeftFields.toggleSurfaceOnly();
+  mDisplayVTKLeft->update();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// [SLOT] slotRightToggleSurfaceButtonClicked()                              //
+///////////////////////////////////////////////////////////////////////////////
+
+void VCompare::slotRightToggleSurfaceButtonClicked()
+{
+  mRightFields.toggleSurfaceOnly();
+  mDisplayVTKRight->update();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// [SLOT] slotLeftToggleSliceButtonClicked()                                 //
+///////////////////////////////////////////////////////////////////////////////
+
+void VCompare::slotLeftToggleSliceButtonClicked()
+{
+  toggleSlicePlane(mLeftFields, mLeftSlicePlaneWidget, leftRenderer);
+  mDisplayVTKLeft->update();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// [SLOT] slotRightToggleSliceButtonClicked()                                //
+///////////////////////////////////////////////////////////////////////////////
+
+void VCompare::slotRightToggleSliceButtonClicked()
+{
+  toggleSlicePlane(mRightFields, mRightSlicePlaneWidget, rightRenderer);
+  mDisplayVTKRight->update();
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // [SLOT] slotArrowScaleChanged()                                            //
 ///////////////////////////////////////////////////////////////////////////////
@@ -583,6 +718,250 @@ void VCompare::slotArrowScaleChanged()
   mDisplayVTKLeft->update();
   mDisplayVTKRight->update();
 
+  updateMemoryStatus();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// [SLOT] slotArrowCountChanged()                                            //
+///////////////////////////////////////////////////////////////////////////////
+
+void VCompare::slotArrowCountChanged()
+{
+  // An empty count draws an arrow at every vertex.
+  bool   status = true;
+  size_t target = 0;
+  if (!mArrowCount->text().trimmed().isEmpty()) {
+    target = mArrowCount->text().trimmed().toULongLong(&status);
+  }
+
+  if (status == false) {
+    statusbar->showMessage(QString("Invalid arrow count: %1").arg(mArrowCount->text()));
+    return;
+  }
+
+  mLeftFields.setGlyphTarget(target, mArrowAdaptive->isChecked());
+  mRightFields.setGlyphTarget(target, mArrowAdaptive->isChecked());
+  DEBUG("Set arrow count to: " << target);
+
+  mDisplayVTKLeft->update();
+  mDisplayVTKRight->update();
+
+  updateMemoryStatus();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// [SLOT] slotColourByChanged()                                              //
+///////////////////////////////////////////////////////////////////////////////
+
+void VCompare::slotColourByChanged(int index)
+{
+  if (mLeftFields.size() == 0) {
+    return;
+  }
+
+  std::string arrayName = mColourBy->itemData(index).toString().toUtf8().constData();
+  mLeftFields.setColourBy(arrayName);
+  mRightFields.setColourBy(arrayName);
+
+  mDisplayVTKLeft->update();
+  mDisplayVTKRight->update();
+
+  updateMemoryStatus();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// [SLOT] slotIsovalueChanged()                                              //
+///////////////////////////////////////////////////////////////////////////////
+
+void VCompare::slotIsovalueChanged(int value)
+{
+  if (mLeftFields.size() == 0) {
+    return;
+  }
+
+  // The slider spans the range of the contoured array over the whole set.
+  double range[2];
+  mLeftFields.isosurfaceRange(range);
+
+  double t = (double)(value - mIsovalue->minimum())
+           / (double)(mIsovalue->maximum() - mIsovalue->minimum());
+  double h = range[0] + t*(range[1] - range[0]);
+
+  mLeftFields.setIsovalue(h);
+  mRightFields.setIsovalue(h);
+
+  mDisplayVTKLeft->update();
+  mDisplayVTKRight->update();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// [SLOT] slotContourByChanged()                                             //
+///////////////////////////////////////////////////////////////////////////////
+
+void VCompare::slotContourByChanged(int index)
+{
+  if (mLeftFields.size() == 0) {
+    return;
+  }
+
+  std::string arrayName = mContourBy->itemData(index).toString().toUtf8().constData();
+  mLeftFields.setIsosurfaceArray(arrayName);
+  mRightFields.setIsosurfaceArray(arrayName);
+
+  resetIsovalue();
+
+  mDisplayVTKLeft->update();
+  mDisplayVTKRight->update();
+
+  updateMemoryStatus();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// [SLOT] slotExpressionEntered()                                            //
+///////////////////////////////////////////////////////////////////////////////
+
+void VCompare::slotExpressionEntered()
+{
+  if (mLeftFields.size() == 0) {
+    return;
+  }
+
+  std::shared_ptr<const Expression> expression;
+  try {
+    expression = std::make_shared<const Expression>(
+        mExpression->text().toUtf8().constData());
+  } catch (ExpressionParseException & e) {
+    ERROR(e.what());
+    statusbar->showMessage(e.what());
+    return;
+  }
+
+  // Only scalars can be coloured by or contoured, e.g. |curl m| rather than
+  // curl m.
+  if (expression->ncomp() != 1) {
+    statusbar->showMessage(
+        QString("Expression must be a scalar (e.g. |a| or a.x): %1")
+        .arg(mExpression->text()));
+    return;
+  }
+
+  // Each model evaluates the expression when it is first needed.
+  mLeftFields.setExpression(expression);
+  mRightFields.setExpression(expression);
+  statusbar->showMessage(QString("Expression: %1").arg(mExpression->text()));
+
+  if (mLeftFields.isosurfaceArray() == "Expression") {
+    resetIsovalue();
+  }
+
+  mDisplayVTKLeft->update();
+  mDisplayVTKRight->update();
+
+  updateMemoryStatus();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// [SLOT] slotMaterialParametersTriggered()                                  //
+///////////////////////////////////////////////////////////////////////////////
+
+void VCompare::slotMaterialParametersTriggered()
+{
+  QDialog dialog(this);
+  dialog.setWindowTitle("Material parameters");
+
+  QFormLayout * form = new QFormLayout(&dialog);
+
+  auto numberEdit = [&](double value) {
+    QLineEdit * edit = new QLineEdit(QString::number(value), &dialog);
+    return edit;
+  };
+
+  auto vectorRow = [&](const QString & label, const Vector3d & v, QLineEdit * edits[3]) {
+    QHBoxLayout * row = new QHBoxLayout();
+    edits[0] = numberEdit(v.x);
+    edits[1] = numberEdit(v.y);
+    edits[2] = numberEdit(v.z);
+    for (int d = 0; d < 3; ++d) {
+      row->addWidget(edits[d]);
+    }
+    form->addRow(label, row);
+  };
+
+  QLineEdit * ms  = numberEdit(mMaterialParameters.ms);
+  QLineEdit * aex = numberEdit(mMaterialParameters.aex);
+  form->addRow("Ms (A/m):", ms);
+  form->addRow("A (J/m):", aex);
+
+  QComboBox * anisotropy = new QComboBox(&dialog);
+  anisotropy->addItem("None",     MaterialParameters::NONE);
+  anisotropy->addItem("Uniaxial", MaterialParameters::UNIAXIAL);
+  anisotropy->addItem("Cubic",    MaterialParameters::CUBIC);
+  anisotropy->setCurrentIndex(mMaterialParameters.anisotropy);
+  form->addRow("Anisotropy:", anisotropy);
+
+  QLineEdit * k1 = numberEdit(mMaterialParameters.k1);
+  QLineEdit * k2 = numberEdit(mMaterialParameters.k2);
+  form->addRow("K1 / Ku (J/m^3):", k1);
+  form->addRow("K2, cubic (J/m^3):", k2);
+
+  QLineEdit * easyAxis[3];
+  QLineEdit * field[3];
+  vectorRow("Easy axis, uniaxial:", mMaterialParameters.easyAxis, easyAxis);
+  vectorRow("Applied field B (T):", mMaterialParameters.field, field);
+
+  QLineEdit * lengthScale = numberEdit(mMaterialParameters.lengthScale);
+  form->addRow("Mesh length unit (m):", lengthScale);
+
+  QDialogButtonBox * buttons = new QDialogButtonBox(
+      QDialogButtonBox::Ok | QDialogButtonBox::Cancel, &dialog);
+  connect(buttons, SIGNAL(accepted()), &dialog, SLOT(accept()));
+  connect(buttons, SIGNAL(rejected()), &dialog, SLOT(reject()));
+  form->addRow(buttons);
+
+  if (dialog.exec() != QDialog::Accepted) {
+    return;
+  }
+
+  // Only accept the parameters if every value is a number.
+  bool ok = true;
+  auto value = [&](QLineEdit * edit) {
+    bool status = false;
+    double v = stringToDouble(edit->text(), status);
+    ok = ok && status;
+    return v;
+  };
+
+  MaterialParameters params;
+  params.ms          = value(ms);
+  params.aex         = value(aex);
+  params.anisotropy  = (MaterialParameters::Anisotropy)anisotropy->currentData().toInt();
+  params.k1          = value(k1);
+  params.k2          = value(k2);
+  params.easyAxis    = {.x = value(easyAxis[0]), .y = value(easyAxis[1]), .z = value(easyAxis[2])};
+  params.field       = {.x = value(field[0]),    .y = value(field[1]),    .z = value(field[2])};
+  params.lengthScale = value(lengthScale);
+
+  if (!ok) {
+    ERROR("Invalid material parameters, keeping the previous parameters");
+    return;
+  }
+  mMaterialParameters = params;
+
+  if (mLeftFields.size() == 0) {
+    return;
+  }
+
+  mLeftFields.setMaterialParameters(mMaterialParameters);
+  mRightFields.setMaterialParameters(mMaterialParameters);
+  updateComputedColumns();
+
+  if (mLeftFields.isosurfaceArray().ends_with("EnergyDensity")) {
+    resetIsovalue();
+  }
+
+  mDisplayVTKLeft->update();
+  mDisplayVTKRight->update();
+  updateMemoryStatus();
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -785,6 +1164,11 @@ void VCompare::clearOverviewTable()
   }
   mRelativeEnergyColumn.clear();
 
+  for (QTableWidgetItem * item : mComputedColumns) {
+    delete item;
+  }
+  mComputedColumns.clear();
+
   mOverviewTable->setRowCount(0);
 }
 
@@ -844,6 +1228,11 @@ void VCompare::updateRenderers(
   mLeftFields  = VectorFieldSet(fieldFiles, leftRenderer,  progress, 0,                 scale);
   mRightFields = VectorFieldSet(fieldFiles, rightRenderer, progress, fieldFiles.size(), scale);
 
+  // Glyphs, isosurfaces etc. are built lazily as models are drawn.
+  mLeftFields.setRenderedCallback([this]() { updateMemoryStatus(); });
+  mRightFields.setRenderedCallback([this]() { updateMemoryStatus(); });
+  slotArrowCountChanged();
+
   INFO("Retreiving energy evaluation data");
   mEnergyEvaluationsLookup = mDatabase.getEnergyEvaluations(
       material, geometry, size, temperature);
@@ -913,6 +1302,18 @@ void VCompare::updateRenderers(
     mOverviewTable->setItem(i, 9, relEnergy);
   }
 
+  // Energies are computed on request, here only for the left set whose
+  // totals are in the table.
+  INFO("Computing energies");
+  mLeftFields.setMaterialParameters(mMaterialParameters);
+  mRightFields.setMaterialParameters(mMaterialParameters);
+  updateComputedColumns();
+
+  slotColourByChanged(mColourBy->currentIndex());
+  slotContourByChanged(mContourBy->currentIndex());
+
+  updateMemoryStatus();
+
   INFO("Set end value for progress box (terminates progress box).");
   progress.setValue(fieldFiles.size()*2);
 
@@ -963,6 +1364,105 @@ void VCompare::updateRenderers(
   setLastButtonGroupActive(end);
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// Function updateComputedColumns()                                          //
+///////////////////////////////////////////////////////////////////////////////
+
+void VCompare::updateComputedColumns()
+{
+  // NOTE: setItem() deletes the item it replaces.
+  mComputedColumns.clear();
+
+  for (size_t i = 0; i < mLeftFields.size(); ++i) {
+    const EnergyTotals & energies = mLeftFields[i]->energies();
+
+    setComputedItem(i, 10, energies.exchange);
+    setComputedItem(i, 11, energies.anisotropy);
+    setComputedItem(i, 12, energies.zeeman);
+    setComputedItem(i, 13, energies.demag);
+    setComputedItem(i, 14, energies.total());
+
+    // Charges relative to the boundary area, so that sizes compare.
+    const MagneticCharges & charges = mLeftFields[i]->charges();
+
+    setComputedItem(i, 15, charges.volumeAbs/charges.area);
+    setComputedItem(i, 16, charges.surfaceAbs/charges.area);
+
+    setComputedItem(i, 17, mLeftFields[i]->topologicalCharge());
+    setComputedItem(i, 18, mLeftFields[i]->vortexCores().size());
+
+    QStringList cores;
+    for (const VortexCore & core : mLeftFields[i]->vortexCores()) {
+      cores << QString("(%1, %2, %3) winding %4, polarity %5")
+          .arg(core.position.x).arg(core.position.y).arg(core.position.z)
+          .arg(core.winding).arg(core.polarity);
+    }
+    mOverviewTable->item(i, 18)->setToolTip(cores.join("\n"));
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Function setComputedItem()                                                //
+///////////////////////////////////////////////////////////////////////////////
+
+void VCompare::setComputedItem(int row, int column, double value)
+{
+  QTableWidgetItem * item = new QTableWidgetItem(QString::number(value));
+  item->setTextAlignment(Qt::AlignRight);
+  mComputedColumns.push_back(item);
+  mOverviewTable->setItem(row, column, item);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Function resetIsovalue()                                                  //
+///////////////////////////////////////////////////////////////////////////////
+
+void VCompare::resetIsovalue()
+{
+  // The slider goes back to the middle and both sets are contoured at the
+  // value it maps to, so that every model matches the slider.
+  mIsovalue->blockSignals(true);
+  mIsovalue->setValue((mIsovalue->minimum() + mIsovalue->maximum())/2);
+  mIsovalue->blockSignals(false);
+
+  slotIsovalueChanged(mIsovalue->value());
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Function updateMemoryStatus()                                             //
+///////////////////////////////////////////////////////////////////////////////
+
+void VCompare::updateMemoryStatus()
+{
+  // The left and right sets are read from the same files so share meshes,
+  // count each mesh once over both sets.
+  std::unordered_set<const TetMesh *> counted;
+  MemoryUsage left  = mLeftFields.memoryUsage(counted);
+  MemoryUsage right = mRightFields.memoryUsage(counted);
+
+  MemoryUsage usage = left;
+  usage += right;
+  // The demag kernels are shared by every model (of either set).
+  usage.derived += DemagKernel::cacheBytes();
+
+  const double MiB = 1024.0*1024.0;
+  size_t arenaHighWaterMark = std::max(mLeftFields.arenaHighWaterMark(),
+                                       mRightFields.arenaHighWaterMark());
+
+  mMemoryStatus->setText(
+      QString("Memory: %1 MiB (left %2, right %3) - "
+              "mesh %4, fields %5, derived %6, pipeline %7 MiB; "
+              "load arena high-water mark %8 KiB")
+      .arg(usage.total()/MiB,    0, 'f', 1)
+      .arg(left.total()/MiB,     0, 'f', 1)
+      .arg(right.total()/MiB,    0, 'f', 1)
+      .arg(usage.mesh/MiB,       0, 'f', 1)
+      .arg(usage.fields/MiB,     0, 'f', 1)
+      .arg(usage.derived/MiB,    0, 'f', 1)
+      .arg(usage.pipeline/MiB,   0, 'f', 1)
+      .arg(arenaHighWaterMark/1024));
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // Function setLeftView()                                                    //
 ///////////////////////////////////////////////////////////////////////////////
@@ -1028,3 +1528,111 @@ double VCompare::stringToDouble(const QString & strDouble, bool & status)
   return 0.0;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// Function setInteractionLevelOfDetail()                                    //
+///////////////////////////////////////////////////////////////////////////////
+
+vtkSmartPointer<vtkCallbackCommand> VCompare::setInteractionLevelOfDetail(
+    vtkRenderWindowInteractor * interactor,
+    VectorFieldSet            * fields)
+{
+  // NOTE: interaction events are invoked on the (concrete) interactor style,
+  //       so the default style switch is replaced by the trackball camera
+  //       style it would otherwise delegate to.
+  vtkSmartPointer<vtkInteractorStyleTrackballCamera> style =
+      vtkSmartPointer<vtkInteractorStyleTrackballCamera>::New();
+  interactor->SetInteractorStyle(style);
+
+  vtkSmartPointer<vtkCallbackCommand> callback =
+      vtkSmartPointer<vtkCallbackCommand>::New();
+  callback->SetCallback(VCompare::interactionCallback);
+  callback->SetClientData(fields);
+
+  style->AddObserver(vtkCommand::StartInteractionEvent, callback);
+  style->AddObserver(vtkCommand::EndInteractionEvent, callback);
+
+  return callback;
+}
+
+void VCompare::interactionCallback(
+    vtkObject     * vtkNotUsed(caller),
+    unsigned long   eventId,
+    void          * clientData,
+    void          * vtkNotUsed(callData))
+{
+  // The style renders again after the end of an interaction, at full detail.
+  VectorFieldSet * fields = static_cast<VectorFieldSet *>(clientData);
+  fields->setInteractive(eventId == vtkCommand::StartInteractionEvent);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Function newSlicePlaneWidget()                                            //
+///////////////////////////////////////////////////////////////////////////////
+
+vtkSmartPointer<vtkImplicitPlaneWidget2> VCompare::newSlicePlaneWidget(
+    vtkRenderWindowInteractor * interactor,
+    VectorFieldSet            * fields)
+{
+  vtkSmartPointer<vtkImplicitPlaneRepresentation> representation =
+      vtkSmartPointer<vtkImplicitPlaneRepresentation>::New();
+  representation->SetPlaceFactor(1.0);
+  representation->OutlineTranslationOff();
+  representation->DrawPlaneOff();
+
+  vtkSmartPointer<vtkImplicitPlaneWidget2> widget =
+      vtkSmartPointer<vtkImplicitPlaneWidget2>::New();
+  widget->SetInteractor(interactor);
+  widget->SetRepresentation(representation);
+
+  vtkSmartPointer<vtkCallbackCommand> callback =
+      vtkSmartPointer<vtkCallbackCommand>::New();
+  callback->SetCallback(VCompare::slicePlaneCallback);
+  callback->SetClientData(fields);
+  widget->AddObserver(vtkCommand::InteractionEvent, callback);
+
+  return widget;
+}
+
+void VCompare::toggleSlicePlane(
+    VectorFieldSet          & fields,
+    vtkImplicitPlaneWidget2 * widget,
+    vtkRenderer             * renderer)
+{
+  if (widget->GetEnabled()) {
+    widget->Off();
+    fields.toggleSlice();
+    return;
+  }
+
+  // Start with the plane normal to z through the middle of the model (the
+  // props displayed before the arrows are swapped for the slice arrows).
+  double bounds[6];
+  renderer->ComputeVisiblePropBounds(bounds);
+
+  vtkImplicitPlaneRepresentation * representation =
+      vtkImplicitPlaneRepresentation::SafeDownCast(widget->GetRepresentation());
+  representation->PlaceWidget(bounds);
+  representation->SetOrigin(
+      0.5*(bounds[0] + bounds[1]), 0.5*(bounds[2] + bounds[3]), 0.5*(bounds[4] + bounds[5]));
+  representation->SetNormal(0.0, 0.0, 1.0);
+
+  fields.setSlicePlane(representation->GetOrigin(), representation->GetNormal());
+  fields.toggleSlice();
+  widget->On();
+}
+
+void VCompare::slicePlaneCallback(
+    vtkObject     * caller,
+    unsigned long   vtkNotUsed(eventId),
+    void          * clientData,
+    void          * vtkNotUsed(callData))
+{
+  // Only the tetrahedra cut by the plane are visited, so re-slicing keeps
+  // up with the drag.
+  vtkImplicitPlaneWidget2 * widget = static_cast<vtkImplicitPlaneWidget2 *>(caller);
+  vtkImplicitPlaneRepresentation * representation =
+      vtkImplicitPlaneRepresentation::SafeDownCast(widget->GetRepresentation());
+
+  VectorFieldSet * fields = static_cast<VectorFieldSet *>(clientData);
+  fields->setSlicePlane(representation->GetOrigin(), representation->GetNormal());
+}
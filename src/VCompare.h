@@ -33,9 +33,8 @@
 #include <utility>
 
 #include <vtkActor.h>
-#include <vtkArrayCalculator.h>
-#include <vtkArrowSource.h>
 #include <vtkAxesActor.h>
+#include <vtkCallbackCommand.h>
 #include <vtkCamera.h>
 #include <vtkCellData.h>
 #include <vtkColorTransferFunction.h>
@@ -45,27 +44,35 @@
 #include <vtkDoubleArray.h>
 #include <vtkElevationFilter.h>
 #include <vtkFloatArray.h>
-#include <vtkGlyph3D.h>
-#include <vtkGradientFilter.h>
+#include <vtkImplicitPlaneRepresentation.h>
+#include <vtkImplicitPlaneWidget2.h>
+#include <vtkInteractorStyleTrackballCamera.h>
 #include <vtkLookupTable.h>
-#include <vtkMaskPoints.h>
 #include <vtkOrientationMarkerWidget.h>
 #include <vtkPointData.h>
 #include <vtkPolyDataMapper.h>
 #include <vtkProperty.h>
 #include <vtkQtTableView.h>
 #include <vtkRenderWindow.h>
+#include <vtkRenderWindowInteractor.h>
 #include <vtkRenderer.h>
 #include <vtkRendererCollection.h>
 #include <vtkSmartPointer.h>
 #include <vtkSphereSource.h>
-#include <vtkTransform.h>
-#include <vtkTransformPolyDataFilter.h>
 #include <vtkUnstructuredGrid.h>
 
-#include <QMainWindow>
+#include <QComboBox>
+#include <QDialog>
+#include <QDialogButtonBox>
 #include <QFileDialog>
 #include <QFileSystemModel>
+#include <QFormLayout>
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QLineEdit>
+#include <QMainWindow>
+#include <QMenu>
+#include <QMenuBar>
 #include <QProgressDialog>
 #include <QRadioButton>
 
@@ -132,8 +139,22 @@ public slots:
 
   void slotLeftToggleIsosurfaceButtonClicked();
   void slotRightToggleIsosurfaceButtonClicked();
+  void slotLeftToggleCoreLinesButtonClicked();
+  void slotRightToggleCoreLinesButtonClicked();
+  void slotLeftToggleSurfaceButtonClicked();
+  void slotRightToggleSurfaceButtonClicked();
+  void slotLeftToggleSliceButtonClicked();
+  void slotRightToggleSliceButtonClicked();
 
   void slotArrowScaleChanged();
+  void slotArrowCountChanged();
+
+  void slotColourByChanged(int index);
+  void slotIsovalueChanged(int value);
+  void slotContourByChanged(int index);
+  void slotExpressionEntered();
+
+  void slotMaterialParametersTriggered();
 
   void slotPathFirstButtonGroupClicked(QAbstractButton *id);
   void slotPathLastButtonGroupClicked(QAbstractButton *id);
@@ -177,6 +198,19 @@ private:
   vtkSmartPointer<vtkOrientationMarkerWidget> mLeftMarkerWidget;
   vtkSmartPointer<vtkOrientationMarkerWidget> mRightMarkerWidget;
 
+  // Switch the arrows of a view to their interactive level of detail while
+  // the camera is moving.
+  vtkSmartPointer<vtkCallbackCommand> mLeftInteractionCallback;
+  vtkSmartPointer<vtkCallbackCommand> mRightInteractionCallback;
+
+  // The (draggable) slice plane of each view.
+  vtkSmartPointer<vtkImplicitPlaneWidget2> mLeftSlicePlaneWidget;
+  vtkSmartPointer<vtkImplicitPlaneWidget2> mRightSlicePlaneWidget;
+
+  // The memory held by the models (permanent, so that messages do not hide
+  // it), refreshed as products are built.
+  QLabel * mMemoryStatus;
+
   // The models.
   VectorFieldSet mLeftFields;
   VectorFieldSet mRightFields;
@@ -231,6 +265,12 @@ private:
   QList<QTableWidgetItem*> mHandednessColumn;
   QList<QTableWidgetItem*> mRelativeEnergyColumn;
 
+  // Items of the columns of quantities computed from the models.
+  QList<QTableWidgetItem*> mComputedColumns;
+
+  // The material parameters used to compute energies.
+  MaterialParameters mMaterialParameters;
+
   QList<StartEndPair> mStartEndPairs;
   int mCurrentSelectedStartEndPairIndex;
   int getMaxStartEndNameIndex();
@@ -251,11 +291,44 @@ private:
       QString size,
       QString temperature);
 
+  void updateMemoryStatus();
+
+  void resetIsovalue();
+
+  void updateComputedColumns();
+
+  void setComputedItem(int row, int column, double value);
+
   void setLeftView(double x, double y, double z);
   void setRightView(double x, double y, double z);
 
   double stringToDouble(const QString & strDouble, bool & status);
 
+  vtkSmartPointer<vtkCallbackCommand> setInteractionLevelOfDetail(
+      vtkRenderWindowInteractor * interactor,
+      VectorFieldSet            * fields);
+
+  static void interactionCallback(
+      vtkObject     * caller,
+      unsigned long   eventId,
+      void          * clientData,
+      void          * callData);
+
+  vtkSmartPointer<vtkImplicitPlaneWidget2> newSlicePlaneWidget(
+      vtkRenderWindowInteractor * interactor,
+      VectorFieldSet            * fields);
+
+  void toggleSlicePlane(
+      VectorFieldSet          & fields,
+      vtkImplicitPlaneWidget2 * widget,
+      vtkRenderer             * renderer);
+
+  static void slicePlaneCallback(
+      vtkObject     * caller,
+      unsigned long   eventId,
+      void          * clientData,
+      void          * callData);
+
 
 };
 
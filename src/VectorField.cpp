@@ -25,33 +25,46 @@
  * SOFTWARE.
  **/
 
+#include <cmath>
+#include <limits>
+
+#include <vtkSMPThreadLocal.h>
+#include <vtkSMPTools.h>
+
 #include "VectorField.h"
 
-VectorField::VectorField(std::string file, double arrowScale):
-  mName(file), mHmin(0.0), mHmax(0.0), mArrowScale(arrowScale)
+VectorField::VectorField(
+    std::string                 file,
+    double                      arrowScale,
+    std::pmr::memory_resource * resource):
+  mName(file), mHmin(0.0), mHmax(0.0), mArrowScale(arrowScale),
+  mColourBy("Helicity"), mGlyphTarget(0), mGlyphAdaptive(false),
+  mArrowsDirty(false), mSurfaceOnly(false), mAdaptiveGlyphTarget(0),
+  mAdaptiveGlyphSurfaceOnly(false), mInteractive(false),
+  mSliceOrigin({.x = 0.0, .y = 0.0, .z = 0.0}),
+  mSliceNormal({.x = 0.0, .y = 0.0, .z = 1.0}), mSliceDirty(false),
+  mIsovalue(std::numeric_limits<double>::quiet_NaN()),
+  mIsosurfaceArray("Helicity")
 {
-  VertexField3d   vert;
-  ConnectIndices4 conn;
-  VectorField3d   field;
+  // Loader temporaries are allocated from 'resource', they are only needed
+  // until the VTK data structures are built.
+  VertexField3d   vert(resource);
+  ConnectIndices4 conn(resource);
+  VectorField3d   field(resource);
 
-  TecplotLoader loader;
+  TecplotLoader loader(resource);
 
   loader.load(file, Loader::ONE_INDEXING, vert, conn, field);
 
-  setGrid(vert, conn);
-
-  setMagnetisation(field);
-
-  setHelicity();
+  mMesh = TetMesh::acquire(vert, conn);
 
-  setGeometry();
+  setGrid();
 
-  setArrows();
+  setMagnetisation(field);
 
   mUGrid->GetPointData()->SetActiveVectors("Magnetisation");
-  mUGrid->GetPointData()->SetActiveScalars("Helicity");
 
-  setIsosurface();
+  // Everything else is derived on first request, see require().
 }
 
 std::vector<std::string> VectorField::split(const std::string & s, char delim)
@@ -77,37 +90,289 @@ std::string VectorField::nameIndex() const
   return end.substr(0, 4);
 }
 
-void VectorField::setIsosurfaceHelicity(double helicity) 
+void VectorField::setIsovalue(double value) 
+{
+  if (value == mIsovalue) {
+    return;
+  }
+
+  mIsovalue = value;
+
+  // An isosurface that has not been built yet is contoured on first request.
+  if (mComputed[ISOSURFACE]) {
+    contourIsosurface();
+  }
+}
+
+void VectorField::setIsosurfaceArray(const std::string & arrayName, double value)
+{
+  double range[2];
+  if (!scalarRange(arrayName, range)) {
+    ERROR("Cannot contour '" << arrayName << "'");
+    return;
+  }
+
+  mIsosurfaceArray = arrayName;
+  mIsovalue        = value;
+  mIsosurfaceSpans.reset();
+
+  if (mComputed[ISOSURFACE]) {
+    contourIsosurface();
+  }
+}
+
+void VectorField::setExpression(std::shared_ptr<const Expression> expression)
+{
+  if (expression->ncomp() != 1) {
+    ERROR("Expression '" << expression->source() << "' is not a scalar");
+    return;
+  }
+
+  // Only recorded here, the array is evaluated on first request.
+  mExpression = expression;
+  mComputed[EXPRESSION] = false;
+
+  // The contoured array has changed, its index is rebuilt when the owner
+  // sets an isovalue for the new range (see setIsosurfaceArray()).
+  if (mIsosurfaceArray == "Expression") {
+    mIsosurfaceSpans.reset();
+  }
+}
+
+size_t VectorField::probe(const VertexField3d & points, VectorField3d & m) const
+{
+  std::vector<TetLocation> loc(points.size());
+  mMesh->bvh().locate(points.data(), points.size(), loc.data());
+
+  const ConnectIndices4 & conn = mMesh->connectivity();
+  const double          * f    = mMagnetisation->GetPointer(0);
+
+  m.resize(points.size());
+  vtkSMPTools::For(0, points.size(), [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType i = begin; i < end; ++i) {
+      if (loc[i].tet < 0) {
+        double nan = std::numeric_limits<double>::quiet_NaN();
+        m[i] = {.x = nan, .y = nan, .z = nan};
+        continue;
+      }
+
+      const Connect4 & c = conn[loc[i].tet];
+      Vector3d v = {.x = 0.0, .y = 0.0, .z = 0.0};
+      for (int k = 0; k < 4; ++k) {
+        const double * fk = f + 3*c[k];
+        v.x += loc[i].bary[k]*fk[0];
+        v.y += loc[i].bary[k]*fk[1];
+        v.z += loc[i].bary[k]*fk[2];
+      }
+      m[i] = v;
+    }
+  });
+
+  return std::count_if(loc.begin(), loc.end(),
+                       [](const TetLocation & l) { return l.tet >= 0; });
+}
+
+void VectorField::setMaterialParameters(
+    std::shared_ptr<const MaterialParameters> params)
 {
-  mIsosurfaceHelicity = helicity;
-  // TODO: implement rest
+  // Only recorded here, the energies are computed on first request.
+  mMaterialParameters = params;
+  mComputed[ENERGIES] = false;
+
+  // The contoured array has changed, as for setExpression().
+  if (mIsosurfaceArray.ends_with("EnergyDensity")) {
+    mIsosurfaceSpans.reset();
+  }
+}
+
+void VectorField::setColourBy(
+    const std::string               & arrayName,
+    vtkSmartPointer<vtkLookupTable>   lut)
+{
+  double range[2];
+  if (!scalarRange(arrayName, range)) {
+    ERROR("No point array named '" << arrayName << "'");
+    return;
+  }
+
+  mColourBy = arrayName;
+  mArrowLut = lut;
+
+  // Arrows that have not been built yet are coloured when they are.
+  if (mComputed[ARROWS]) {
+    applyColourBy();
+  }
+  if (mComputed[SLICE]) {
+    colourSlice();
+  }
+}
+
+bool VectorField::scalarRange(const std::string & arrayName, double range[2])
+{
+  requireArray(arrayName);
+
+  vtkDataArray * a = mUGrid->GetPointData()->GetArray(arrayName.c_str());
+  if (a == nullptr || a->GetNumberOfComponents() != 1) {
+    return false;
+  }
+
+  a->GetRange(range);
+
+  return true;
+}
+
+double VectorField::volumeAverage(const std::string & arrayName)
+{
+  requireArray(arrayName);
+
+  vtkDoubleArray * f = vtkDoubleArray::SafeDownCast(
+      mUGrid->GetPointData()->GetArray(arrayName.c_str()));
+
+  if (f == nullptr || f->GetNumberOfComponents() != 1) {
+    return std::numeric_limits<double>::quiet_NaN();
+  }
+
+  double average = 0.0;
+  mMesh->geometry().volumeAverage(f->GetPointer(0), 1, &average);
+
+  return average;
+}
+
+void VectorField::resample(const UniformGrid & grid, VectorField3d & m) const
+{
+  mMesh->resampler(grid)->resample(mMagnetisation->GetPointer(0), m);
+}
+
+MemoryUsage VectorField::memoryUsage() const
+{
+  // NOTE: VTK reports sizes in KiB.
+  const size_t KiB = 1024;
+
+  MemoryUsage usage;
+
+  usage.mesh = mMesh->memoryBytes();
+
+  vtkPointData * pd = mUGrid->GetPointData();
+  for (int i = 0; i < pd->GetNumberOfArrays(); ++i) {
+    vtkDataArray * a = pd->GetArray(i);
+    if (a == mMagnetisation.GetPointer()) {
+      usage.fields  += a->GetActualMemorySize()*KiB;
+    } else {
+      usage.derived += a->GetActualMemorySize()*KiB;
+    }
+  }
+
+  // The grid, less its point data and the points/cells shared with the mesh.
+  size_t shared = pd->GetActualMemorySize()
+                + mUGrid->GetPoints()->GetActualMemorySize()
+                + mUGrid->GetCells()->GetActualMemorySize();
+  // NOTE: sizes are rounded to KiB per object, so the difference may be
+  //       (slightly) negative.
+  size_t grid = mUGrid->GetActualMemorySize();
+  usage.pipeline += (grid > shared) ? (grid - shared)*KiB : 0;
+  if (mComputed[ARROWS]) {
+    usage.pipeline += mArrowGlyphs.memoryBytes();
+    usage.pipeline += mCoarseArrowGlyphs.memoryBytes();
+  }
+  if (mComputed[ISOSURFACE]) {
+    usage.pipeline += mIsosurface->GetActualMemorySize()*KiB;
+  }
+  if (mComputed[SLICE]) {
+    usage.pipeline += mSliceGlyphs.memoryBytes();
+  }
+  if (mComputed[CORE_LINES]) {
+    usage.pipeline += mCoreLines->GetActualMemorySize()*KiB;
+  }
+
+  usage.derived += mPatchCharges.capacity()*sizeof(double)
+                 + mVortexCores.capacity()*sizeof(VortexCore)
+                 + mAdaptiveGlyphSample.capacity()*sizeof(vtkIdType)
+                 + mSlice.points.capacity()*sizeof(Vertex3d)
+                 + mSlice.edges.capacity()*sizeof(Connect2::Key)
+                 + (mSlice.weights.capacity() + mSliceVectors.capacity()
+                    + mSliceScalar.capacity())*sizeof(double);
+  if (mIsosurfaceSpans) {
+    usage.derived += mIsosurfaceSpans->memoryBytes();
+  }
+
+  return usage;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 // Private functions.
 ///////////////////////////////////////////////////////////////////////////////
 
-void VectorField::setGrid(
-    const VertexField3d & vert, 
-    const ConnectIndices4 & conn)
+/// The products that each product is derived from (besides m).
+static const std::vector<VectorField::Product> sDependencies[VectorField::NPRODUCTS] = {
+  /* HELICITY        */ {},
+  /* VOLUME_AVERAGES */ {VectorField::HELICITY},
+  /* CHARGES         */ {},
+  /* TOPOLOGY        */ {},
+  /* EXPRESSION      */ {},
+  /* ENERGIES        */ {},
+  /* GEOMETRY        */ {},
+  /* ARROWS          */ {},
+  /* CORE_LINES      */ {VectorField::VOLUME_AVERAGES},
+  /* ISOSURFACE      */ {},
+  /* SLICE           */ {}
+};
+
+void VectorField::require(Product product)
 {
-  mUGrid = vtkSmartPointer<vtkUnstructuredGrid>::New();
-  
-  // Add vertices to the unstructured grid.
-  vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
-  points->SetNumberOfPoints(vert.size());
-  for (size_t i = 0; i < vert.size(); ++i) {
-    points->SetPoint(i, vert[i].x, vert[i].y, vert[i].z);
+  if (mComputed[product]) {
+    return;
+  }
+
+  for (Product dependency : sDependencies[product]) {
+    require(dependency);
+  }
+
+  switch (product) {
+    case HELICITY:        setHelicity();        break;
+    case VOLUME_AVERAGES: setVolumeAverages();  break;
+    case CHARGES:         setCharges();         break;
+    case TOPOLOGY:        setTopology();        break;
+    case EXPRESSION:      evaluateExpression(); break;
+    case ENERGIES:        setEnergies();        break;
+    case GEOMETRY:        setGeometry();        break;
+    case ARROWS:          setArrows();          break;
+    case CORE_LINES:      setCoreLines();       break;
+    case ISOSURFACE:      setIsosurface();      break;
+    case SLICE:           setSlice();           break;
+    default:                                    return;
   }
-  mUGrid->SetPoints(points);
 
-  // Add connectivity information to unstructured grid.
-  for (size_t i = 0; i < conn.size(); ++i) {
-    vtkIdType element[4] = {conn[i].n0, conn[i].n1, conn[i].n2, conn[i].n3}; 
-    mUGrid->InsertNextCell(VTK_TETRA, 4, element);
+  mComputed[product] = true;
+}
+
+void VectorField::requireArray(const std::string & arrayName)
+{
+  // NOTE: the arrows and the isosurface depend on whichever array they are
+  //       coloured by or contour, so those dependencies are resolved here
+  //       rather than in sDependencies.
+  if (arrayName == "Helicity") {
+    require(HELICITY);
+  } else if (arrayName == "VolumeCharge" || arrayName == "SurfaceCharge") {
+    require(CHARGES);
+  } else if (arrayName == "TopologicalChargeDensity") {
+    require(TOPOLOGY);
+  } else if (arrayName == "Expression") {
+    require(EXPRESSION);
+  } else if (arrayName.ends_with("EnergyDensity")) {
+    require(ENERGIES);
   }
 }
 
+void VectorField::setGrid()
+{
+  mUGrid = vtkSmartPointer<vtkUnstructuredGrid>::New();
+
+  // Points and cells are shared by the grids of all models on the mesh, only
+  // the point data is per model.
+  mUGrid->SetPoints(mMesh->points());
+  mUGrid->SetCells(VTK_TETRA, mMesh->cells());
+}
+
 void VectorField::setMagnetisation(const VectorField3d & field)
 {
   vtkSmartPointer<vtkDoubleArray> f = 
@@ -116,84 +381,258 @@ void VectorField::setMagnetisation(const VectorField3d & field)
   f->SetNumberOfComponents(3);
   f->SetNumberOfTuples(field.size());
 
-  mMx = 0.0;
-  mMy = 0.0;
-  mMz = 0.0;
-  mMmag = 0.0;
-  for (size_t i = 0; i < field.size(); ++i) {
-    double fd[3] = {field[i].x, field[i].y , field[i].z};
-    f->SetTuple(i, fd);
-    mMx += fd[0];
-    mMy += fd[1];
-    mMz += fd[2];
-  }
+  // NOTE: the mean etc. are accumulated along with the helicity, see
+  //       setHelicity().
+  double * fd = f->GetPointer(0);
+  vtkSMPTools::For(0, field.size(), [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType i = begin; i < end; ++i) {
+      fd[3*i]   = field[i].x;
+      fd[3*i+1] = field[i].y;
+      fd[3*i+2] = field[i].z;
+    }
+  });
   mUGrid->GetPointData()->AddArray(f);
-
-  mMx /= (double)field.size();
-  mMy /= (double)field.size();
-  mMz /= (double)field.size();
-
-  mMmag = sqrt(mMx*mMx + mMy*mMy + mMz*mMz);
-
-  mMx /= mMmag;
-  mMy /= mMmag;
-  mMz /= mMmag;
+  mMagnetisation = f;
 }
 
-void VectorField::setHelicity() 
+/**
+ * Parallel pass over vertices that recovers the nodal curl from the (volume
+ * weighted) per-tetrahedron curl, forms the helicity m.(curl m) and
+ * accumulates the field statistics.
+ */
+struct HelicityFunctor
 {
-  vtkSmartPointer<vtkGradientFilter> vorticity =
-    vtkSmartPointer<vtkGradientFilter>::New();
-
-  vtkSmartPointer<vtkArrayCalculator> helicity =
-    vtkSmartPointer<vtkArrayCalculator>::New();
+  const TetGeometry                  & geometry;
+  const double                       * m;
+  const Vector3d                     * curl;
+  double                             * h;
+  vtkSMPThreadLocal<FieldStatistics>   local;
+  FieldStatistics                      statistics;
+
+  HelicityFunctor(
+      const TetGeometry & g, const double * m, const Vector3d * curl, double * h) :
+    geometry(g), m(m), curl(curl), h(h)
+  {}
+
+  // Thread locals are default constructed (empty) statistics.
+  void Initialize() {}
+
+  void operator() (vtkIdType begin, vtkIdType end)
+  {
+    FieldStatistics & stats = local.Local();
+    for (vtkIdType v = begin; v < end; ++v) {
+      const double * mv = m + 3*v;
+      Vector3d c  = geometry.gather(v, curl);
+      double   hv = mv[0]*c.x + mv[1]*c.y + mv[2]*c.z;
+      h[v] = hv;
+      stats.add(mv, hv);
+    }
+  }
 
-  // Vorticity.
-  vorticity->ComputeVorticityOn();
-  vorticity->SetInputArrayToProcess(0, 0, 0, 0, "Magnetisation");
-  vorticity->SetVorticityArrayName("Vorticity");
-  vorticity->SetInputData(mUGrid);
-  vorticity->Update();
+  void Reduce()
+  {
+    statistics = FieldStatistics();
+    for (const FieldStatistics & stats : local) {
+      statistics.merge(stats);
+    }
+  }
+};
 
-  // Helicity.
-  helicity->SetAttributeModeToUsePointData();
-  helicity->AddVectorArrayName("Magnetisation");
-  helicity->AddVectorArrayName("Vorticity");
-  helicity->SetResultArrayName("Helicity");
-  helicity->SetFunction("Magnetisation.Vorticity");
-  helicity->SetInputData(vorticity->GetOutput());
-  helicity->Update();
+void VectorField::setHelicity() 
+{
+  const TetGeometry & geometry = mMesh->geometry();
 
-  // Add helicity field.
-  vtkUnstructuredGrid * hug = 
-    vtkUnstructuredGrid::SafeDownCast(helicity->GetOutput());
+  const double * m = mMagnetisation->GetPointer(0);
 
-  vtkSmartPointer<vtkDoubleArray> h =
-    vtkDoubleArray::SafeDownCast(hug->GetPointData()->GetArray("Helicity"));
+  // Volume weighted curl in each tetrahedron.
+  std::vector<Vector3d> curl(geometry.ntet());
+  geometry.tetCurl(m, curl.data());
 
+  // Helicity and statistics at the vertices, in one pass.
   vtkSmartPointer<vtkDoubleArray> hd = vtkSmartPointer<vtkDoubleArray>::New();
   hd->SetName("Helicity");
   hd->SetNumberOfComponents(1);
-  hd->SetNumberOfTuples(h->GetNumberOfTuples());
+  hd->SetNumberOfTuples(geometry.nvert());
+
+  HelicityFunctor helicity(geometry, m, curl.data(), hd->GetPointer(0));
+  vtkSMPTools::For(0, geometry.nvert(), helicity);
 
-  double hmin = 1E12, hmax = -1E12;
-  for (int i = 0; i < h->GetNumberOfTuples(); ++i) {
-    hmin = (h->GetValue(i) < hmin) ? h->GetValue(i) : hmin;
-    hmax = (h->GetValue(i) > hmax) ? h->GetValue(i) : hmax;
-    hd->SetValue(i, h->GetTuple(i)[0]);
-  }
   mUGrid->GetPointData()->AddArray(hd);
-  mHmin = hmin;
-  mHmax = hmax;
+
+  mStatistics = helicity.statistics;
+  mHmin = mStatistics.hmin();
+  mHmax = mStatistics.hmax();
   DEBUG("hMin: " << mHmin);
   DEBUG("hMax: " << mHmax);
+
+  Vector3d mean = mStatistics.mean();
+  mMmag = norm(mean);
+  mMx = mean.x/mMmag;
+  mMy = mean.y/mMmag;
+  mMz = mean.z/mMmag;
+}
+
+void VectorField::setVolumeAverages()
+{
+  const TetGeometry & geometry = mMesh->geometry();
+
+  double m[3];
+  geometry.volumeAverage(mMagnetisation->GetPointer(0), 3, m);
+  mVolumeMean = {.x = m[0], .y = m[1], .z = m[2]};
+
+  mHvolumeMean = volumeAverage("Helicity");
+}
+
+void VectorField::setCharges()
+{
+  const TetGeometry     & geometry = mMesh->geometry();
+  const BoundarySurface & boundary = mMesh->boundary();
+
+  const double * m = mMagnetisation->GetPointer(0);
+
+  // Volume charge, from the (volume weighted) divergence in each tetrahedron.
+  std::vector<double> div(geometry.ntet());
+  geometry.tetDivergence(m, div.data());
+
+  // Surface charge on each boundary face.
+  std::vector<double> mn(boundary.nface());
+  boundary.normalComponent(m, mn.data());
+
+  double * volumeCharge  = scalarArray("VolumeCharge")->GetPointer(0);
+  double * surfaceCharge = scalarArray("SurfaceCharge")->GetPointer(0);
+  vtkSMPTools::For(0, geometry.nvert(), [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType v = begin; v < end; ++v) {
+      volumeCharge[v]  = -geometry.gather(v, div.data());
+      surfaceCharge[v] = boundary.gather(v, mn.data());
+    }
+  });
+
+  // Totals, these are short serial sums next to the passes above.
+  mCharges = MagneticCharges();
+  for (double d : div) {
+    mCharges.volume    -= d;
+    mCharges.volumeAbs += fabs(d);
+  }
+  const std::vector<double> & areas = boundary.areas();
+  for (size_t f = 0; f < mn.size(); ++f) {
+    mCharges.surface    += areas[f]*mn[f];
+    mCharges.surfaceAbs += areas[f]*fabs(mn[f]);
+  }
+  mCharges.area = boundary.area();
+
+  DEBUG("Charge (volume, surface): " << mCharges.volume << ", " << mCharges.surface);
+}
+
+void VectorField::setTopology()
+{
+  const BoundarySurface & boundary = mMesh->boundary();
+
+  const double * m = mMagnetisation->GetPointer(0);
+
+  std::vector<double> q(boundary.nface());
+  topological_charge(boundary, m, q.data());
+
+  mPatchCharges.resize(boundary.npatch());
+  boundary.patchSum(q.data(), mPatchCharges.data());
+
+  mTopologicalCharge = 0.0;
+  for (double qp : mPatchCharges) {
+    mTopologicalCharge += qp;
+  }
+
+  // The density (charge per unit area) on each face, gathered to vertices.
+  const std::vector<double> & areas = boundary.areas();
+  vtkSMPTools::For(0, q.size(), [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType f = begin; f < end; ++f) {
+      q[f] = areas[f] > 0.0 ? q[f]/areas[f] : 0.0;
+    }
+  });
+
+  double * density = scalarArray("TopologicalChargeDensity")->GetPointer(0);
+  vtkSMPTools::For(0, mMesh->nvert(), [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType v = begin; v < end; ++v) {
+      density[v] = boundary.gather(v, q.data());
+    }
+  });
+
+  mVortexCores = vortex_cores(boundary, mMesh->vertices(), m);
+
+  DEBUG("Topological charge: " << mTopologicalCharge << ", vortex cores: " << mVortexCores.size());
+}
+
+void VectorField::evaluateExpression()
+{
+  if (!mExpression) {
+    return;
+  }
+
+  mExpression->evaluate(
+      mMesh->vertices(), mMesh->geometry(), mMagnetisation->GetPointer(0),
+      scalarArray("Expression")->GetPointer(0));
+
+  DEBUG("Evaluated expression '" << mExpression->source() << "'");
+}
+
+void VectorField::setEnergies()
+{
+  if (!mMaterialParameters) {
+    return;
+  }
+
+  const MaterialParameters & params = *mMaterialParameters;
+
+  double * exchange   = scalarArray("ExchangeEnergyDensity")->GetPointer(0);
+  double * anisotropy = scalarArray("AnisotropyEnergyDensity")->GetPointer(0);
+  double * zeeman     = scalarArray("ZeemanEnergyDensity")->GetPointer(0);
+  double * total      = scalarArray("EnergyDensity")->GetPointer(0);
+
+  mEnergies = compute_energies(
+      mMesh->geometry(), mMagnetisation->GetPointer(0), params,
+      exchange, anisotropy, zeeman);
+
+  vtkSMPTools::For(0, mMesh->nvert(), [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType i = begin; i < end; ++i) {
+      total[i] = exchange[i] + anisotropy[i] + zeeman[i];
+    }
+  });
+  mUGrid->GetPointData()->Modified();
+
+  // Demag energy from m resampled on to a grid of cubic cells, both the
+  // resampling weights and the tensor transform are cached.
+  UniformGrid   grid = demag_grid(mMesh->bounds(), DemagGridCells);
+  VectorField3d m;
+  resample(grid, m);
+  mEnergies.demag = demag_energy(grid, m, params.ms, params.lengthScale);
+
+  DEBUG("Energy (exchange, anisotropy, Zeeman, demag): " << mEnergies.exchange
+        << ", " << mEnergies.anisotropy << ", " << mEnergies.zeeman << ", "
+        << mEnergies.demag);
+}
+
+vtkDoubleArray * VectorField::scalarArray(const char * name)
+{
+  vtkDoubleArray * a = vtkDoubleArray::SafeDownCast(
+      mUGrid->GetPointData()->GetArray(name));
+
+  if (a == nullptr) {
+    vtkSmartPointer<vtkDoubleArray> na = vtkSmartPointer<vtkDoubleArray>::New();
+    na->SetName(name);
+    na->SetNumberOfComponents(1);
+    na->SetNumberOfTuples(mMesh->nvert());
+    mUGrid->GetPointData()->AddArray(na);
+    a = na;
+  } else {
+    a->Modified();
+  }
+
+  return a;
 }
 
 void VectorField::setGeometry()
 {
   mGeometryDataMapper = vtkSmartPointer<vtkDataSetMapper>::New();
-  mGeometryDataMapper->SetInputData(mUGrid);
   mGeometryDataMapper->ScalarVisibilityOff();
+  setGeometryInput();
 
   mGeometryActor = vtkSmartPointer<vtkActor>::New();
   mGeometryActor->SetMapper(mGeometryDataMapper);
@@ -204,49 +643,283 @@ void VectorField::setGeometry()
   mGeometryActor->GetProperty()->SetSpecular(0.0);
 }
 
+void VectorField::setGeometryInput()
+{
+  // The surface triangles are shared by every model on the mesh.
+  if (mSurfaceOnly) {
+    mGeometryDataMapper->SetInputData(mMesh->surface());
+  } else {
+    mGeometryDataMapper->SetInputData(mUGrid);
+  }
+}
+
 void VectorField::setArrows()
 {
-  mArrowSource = vtkSmartPointer<vtkArrowSource>::New();
-  mArrowSource->SetShaftResolution(10);
-  mArrowSource->SetTipResolution(30);
+  glyphArrows();
 
-  mArrowTransform = vtkSmartPointer<vtkTransform>::New();
-  mArrowTransform->Translate(-0.5, 0.0, 0.0);
+  mArrowGlyphPolyDataMapper = vtkSmartPointer<vtkPolyDataMapper>::New();
+  mArrowGlyphPolyDataMapper->SetInputData(mArrowGlyphs.output());
 
-  mArrowTransformFilter = vtkSmartPointer<vtkTransformPolyDataFilter>::New();
-  mArrowTransformFilter->SetTransform(mArrowTransform);
-  mArrowTransformFilter->SetInputConnection(mArrowSource->GetOutputPort());
+  mCoarseArrowGlyphPolyDataMapper = vtkSmartPointer<vtkPolyDataMapper>::New();
+  mCoarseArrowGlyphPolyDataMapper->SetInputData(mCoarseArrowGlyphs.output());
 
-  mArrowGlyph = vtkSmartPointer<vtkGlyph3D>::New();
-  mArrowGlyph->SetInputData(mUGrid);
-  mArrowGlyph->SetSourceConnection(mArrowTransformFilter->GetOutputPort());
-  mArrowGlyph->SetScaleModeToScaleByVector();
-  mArrowGlyph->SetVectorModeToUseVector();
-  mArrowGlyph->SetColorModeToColorByScalar();
-  mArrowGlyph->ScalingOn();
-  mArrowGlyph->OrientOn();
-  mArrowGlyph->SetScaleFactor(mArrowScale);
-  mArrowGlyph->Update();
+  mArrowActor = vtkSmartPointer<vtkActor>::New();
+  mArrowActor->SetMapper(
+      mInteractive ? mCoarseArrowGlyphPolyDataMapper : mArrowGlyphPolyDataMapper);
 
-  mArrowGlyphPolyDataMapper = vtkSmartPointer<vtkPolyDataMapper>::New();
-  mArrowGlyphPolyDataMapper->SetInputConnection(mArrowGlyph->GetOutputPort());
-  mArrowGlyphPolyDataMapper->Update();
+  // Colour with the colour-by state set before the arrows were built.
+  applyColourBy();
+}
 
-  mArrowActor = vtkSmartPointer<vtkActor>::New();
-  mArrowActor->SetMapper(mArrowGlyphPolyDataMapper);
+void VectorField::glyphArrows()
+{
+  const ArrowTemplate          & arrow = ArrowTemplate::get(ArrowTemplate::FINE);
+  const std::vector<vtkIdType> * ids   = glyphSample();
+
+  if (ids == NULL) {
+    mArrowGlyphs.build(
+        arrow, mMesh->vertices(), mMagnetisation->GetPointer(0), mArrowScale);
+  } else {
+    mArrowGlyphs.build(
+        arrow, mMesh->vertices(), mMagnetisation->GetPointer(0), mArrowScale,
+        ids->data(), ids->size());
+  }
+
+  // The interactive set is built along with the full set, so that switching
+  // between them is only a change of mapper. It is a uniform subset of at
+  // most InteractiveGlyphs vertices drawn with low-poly arrows. The target
+  // is the requested one (not the size of an adaptive sample, which varies
+  // by model) so that every model on the mesh shares the sample.
+  size_t requested = (mGlyphTarget == 0) ? mMesh->nvert() : mGlyphTarget;
+  size_t target    = std::min(requested, (size_t)InteractiveGlyphs);
+  const ArrowTemplate & coarse = ArrowTemplate::get(ArrowTemplate::COARSE);
+  if (target >= mMesh->nvert() && !mSurfaceOnly) {
+    mCoarseArrowGlyphs.build(
+        coarse, mMesh->vertices(), mMagnetisation->GetPointer(0), mArrowScale);
+  } else {
+    mCoarseGlyphSample = mMesh->glyphSample(target, mSurfaceOnly);
+    mCoarseArrowGlyphs.build(
+        coarse, mMesh->vertices(), mMagnetisation->GetPointer(0), mArrowScale,
+        mCoarseGlyphSample->data(), mCoarseGlyphSample->size());
+  }
+}
+
+void VectorField::setInteractive(bool interactive)
+{
+  mInteractive = interactive;
+
+  // Arrows that have not been built yet pick their mapper when they are.
+  if (mComputed[ARROWS]) {
+    mArrowActor->SetMapper(
+        mInteractive ? mCoarseArrowGlyphPolyDataMapper : mArrowGlyphPolyDataMapper);
+  }
+}
+
+const std::vector<vtkIdType> * VectorField::glyphSample()
+{
+  bool all = mGlyphTarget == 0 || mGlyphTarget >= mMesh->nvert();
+  if (all && !mSurfaceOnly) {
+    return NULL;
+  }
+
+  // NOTE: a sample with a zero target is every candidate vertex, i.e. every
+  //       surface vertex here.
+  if (!mGlyphAdaptive || all) {
+    mGlyphSample = mMesh->glyphSample(all ? 0 : mGlyphTarget, mSurfaceOnly);
+    return mGlyphSample.get();
+  }
+
+  if (mAdaptiveGlyphTarget != mGlyphTarget
+      || mAdaptiveGlyphSurfaceOnly != mSurfaceOnly) {
+    // Weight the vertices by |grad m|.
+    const TetGeometry & geometry = mMesh->geometry();
+
+    std::vector<double> g2(geometry.ntet());
+    geometry.tetGradientNorm2(mMagnetisation->GetPointer(0), g2.data());
+
+    std::vector<double> weight(geometry.nvert());
+    vtkSMPTools::For(0, geometry.nvert(), [&](vtkIdType begin, vtkIdType end) {
+      for (vtkIdType v = begin; v < end; ++v) {
+        weight[v] = sqrt(geometry.gather(v, g2.data()));
+      }
+    });
+
+    if (mSurfaceOnly) {
+      const std::vector<vtkIdType> & candidates = mMesh->boundary().vertices();
+      glyph_sample(
+          mMesh->vertices(), candidates.data(), candidates.size(), mGlyphTarget,
+          weight.data(), mAdaptiveGlyphSample);
+    } else {
+      glyph_sample(
+          mMesh->vertices(), mGlyphTarget, weight.data(), mAdaptiveGlyphSample);
+    }
+    mAdaptiveGlyphTarget      = mGlyphTarget;
+    mAdaptiveGlyphSurfaceOnly = mSurfaceOnly;
+  }
+
+  return &mAdaptiveGlyphSample;
+}
+
+void VectorField::setGlyphTarget(size_t target, bool adaptive)
+{
+  if (target == mGlyphTarget && adaptive == mGlyphAdaptive) {
+    return;
+  }
+
+  mGlyphTarget   = target;
+  mGlyphAdaptive = adaptive;
+
+  // Arrows that have not been built yet are glyphed with the new subset.
+  mArrowsDirty = mComputed[ARROWS];
+}
+
+void VectorField::setSurfaceOnly(bool surfaceOnly)
+{
+  if (surfaceOnly == mSurfaceOnly) {
+    return;
+  }
+
+  mSurfaceOnly = surfaceOnly;
+
+  // As for the glyph target, arrows are re-glyphed when next requested.
+  mArrowsDirty = mComputed[ARROWS];
+
+  if (mComputed[GEOMETRY]) {
+    setGeometryInput();
+  }
+}
+
+vtkSmartPointer<vtkActor> VectorField::arrows()
+{
+  require(ARROWS);
+
+  if (mArrowsDirty) {
+    // A different number of glyphs, so the scalars are rewritten too.
+    DEBUG("Re-glyphing arrows with target " << mGlyphTarget);
+    glyphArrows();
+    applyColourBy();
+    mArrowsDirty = false;
+  } else if (fabs(mArrowGlyphs.scale() - mArrowScale) > 1E-9) {
+    DEBUG("Re-glyphing arrows with scale " << mArrowScale);
+    glyphArrows();
+  }
+
+  return mArrowActor;
+}
+
+void VectorField::applyColourBy()
+{
+  double range[2];
+  if (!scalarRange(mColourBy, range)) {
+    ERROR("No point array named '" << mColourBy << "'");
+    return;
+  }
+
+  // Only the glyph scalars are rewritten, not the geometry.
+  vtkDoubleArray * scalar = vtkDoubleArray::SafeDownCast(
+      mUGrid->GetPointData()->GetArray(mColourBy.c_str()));
+  mArrowGlyphs.colour(scalar->GetPointer(0));
+  mCoarseArrowGlyphs.colour(scalar->GetPointer(0));
+
+  for (vtkPolyDataMapper * mapper : {mArrowGlyphPolyDataMapper.GetPointer(),
+                                     mCoarseArrowGlyphPolyDataMapper.GetPointer()}) {
+    if (mArrowLut != NULL) {
+      mapper->SetLookupTable(mArrowLut);
+    }
+    mapper->SetScalarRange(range);
+    mapper->Update();
+  }
+}
+
+void VectorField::setSlicePlane(const Vertex3d & origin, const Vector3d & normal)
+{
+  mSliceOrigin = origin;
+  mSliceNormal = normal;
+
+  // Slice arrows that have not been built yet are sliced on this plane.
+  mSliceDirty = mComputed[SLICE];
+}
+
+vtkSmartPointer<vtkActor> VectorField::sliceArrows()
+{
+  require(SLICE);
+
+  if (mSliceDirty) {
+    glyphSlice();
+    colourSlice();
+    mSliceDirty = false;
+  } else if (fabs(mSliceGlyphs.scale() - mArrowScale) > 1E-9) {
+    glyphSlice();
+  }
+
+  return mSliceActor;
+}
+
+void VectorField::setSlice()
+{
+  glyphSlice();
+
+  mSliceGlyphPolyDataMapper = vtkSmartPointer<vtkPolyDataMapper>::New();
+  mSliceGlyphPolyDataMapper->SetInputData(mSliceGlyphs.output());
+
+  mSliceActor = vtkSmartPointer<vtkActor>::New();
+  mSliceActor->SetMapper(mSliceGlyphPolyDataMapper);
+
+  colourSlice();
+}
+
+void VectorField::glyphSlice()
+{
+  // The tetrahedra are indexed by height along the normal once per mesh (and
+  // orientation), so moving the plane only visits the tetrahedra it cuts.
+  mMesh->planeSlicer(mSliceNormal)->slice(mSliceOrigin, mSliceNormal, mSlice);
+
+  mSliceVectors.resize(3*mSlice.size());
+  mSlice.interpolate(mMagnetisation->GetPointer(0), 3, mSliceVectors.data());
+
+  mSliceGlyphs.build(
+      ArrowTemplate::get(ArrowTemplate::FINE), mSlice.points,
+      mSliceVectors.data(), mArrowScale);
+}
+
+void VectorField::colourSlice()
+{
+  double range[2];
+  if (!scalarRange(mColourBy, range)) {
+    ERROR("No point array named '" << mColourBy << "'");
+    return;
+  }
+
+  vtkDoubleArray * scalar = vtkDoubleArray::SafeDownCast(
+      mUGrid->GetPointData()->GetArray(mColourBy.c_str()));
+  mSliceScalar.resize(mSlice.size());
+  mSlice.interpolate(scalar->GetPointer(0), 1, mSliceScalar.data());
+  mSliceGlyphs.colour(mSliceScalar.data());
+
+  if (mArrowLut != NULL) {
+    mSliceGlyphPolyDataMapper->SetLookupTable(mArrowLut);
+  }
+  mSliceGlyphPolyDataMapper->SetScalarRange(range);
+  mSliceGlyphPolyDataMapper->Update();
 }
 
 void VectorField::setIsosurface() 
 {
-  double h = (mHmin+mHmax)/2;
-  DEBUG("Isosurface helicity: " << h);
-  mIsosurface = vtkSmartPointer<vtkContourGrid>::New();
-  mIsosurface->SetInputData(mUGrid);
-  mIsosurface->SetValue(0, h);
+  // Contour at the middle of the helicity range unless an isovalue was set.
+  if (std::isnan(mIsovalue)) {
+    mIsovalue = hmid();
+  }
+  requireArray(mIsosurfaceArray);
 
   mIsosurfacePolyDataMapper = vtkSmartPointer<vtkPolyDataMapper>::New();
   mIsosurfacePolyDataMapper->ScalarVisibilityOff();
-  mIsosurfacePolyDataMapper->SetInputData(mIsosurface->GetOutput());
+
+  vtkDoubleArray * scalar = vtkDoubleArray::SafeDownCast(
+      mUGrid->GetPointData()->GetArray(mIsosurfaceArray.c_str()));
+  mIsosurface = marching_tets(
+      mMesh->vertices(), mMesh->connectivity(), scalar->GetPointer(0),
+      {mIsovalue});
+  mIsosurfacePolyDataMapper->SetInputData(mIsosurface);
   mIsosurfacePolyDataMapper->Update();
 
   mIsosurfaceActor = vtkSmartPointer<vtkActor>::New();
@@ -255,6 +928,50 @@ void VectorField::setIsosurface()
   mIsosurfaceActor->Modified();
 }
 
+void VectorField::setCoreLines()
+{
+  // Cores run (roughly) along the net magnetisation.
+  Vector3d axis = mVolumeMean;
+  if (norm(axis) < 1E-12) {
+    axis = {.x = 0.0, .y = 0.0, .z = 1.0};
+  }
+
+  mCoreLines = core_lines(
+      mMesh->vertices(), mMesh->connectivity(), mMagnetisation->GetPointer(0), axis);
+
+  mCoreLinesPolyDataMapper = vtkSmartPointer<vtkPolyDataMapper>::New();
+  mCoreLinesPolyDataMapper->ScalarVisibilityOff();
+  mCoreLinesPolyDataMapper->SetInputData(mCoreLines);
+
+  mCoreLinesActor = vtkSmartPointer<vtkActor>::New();
+  mCoreLinesActor->SetMapper(mCoreLinesPolyDataMapper);
+  mCoreLinesActor->GetProperty()->SetColor(1.0, 1.0, 0.0);
+  mCoreLinesActor->GetProperty()->SetLineWidth(3.0);
+}
+
+void VectorField::contourIsosurface()
+{
+  DEBUG("Isosurface " << mIsosurfaceArray << ": " << mIsovalue);
+
+  requireArray(mIsosurfaceArray);
+
+  const double * scalar = vtkDoubleArray::SafeDownCast(
+      mUGrid->GetPointData()->GetArray(mIsosurfaceArray.c_str()))->GetPointer(0);
+
+  if (!mIsosurfaceSpans) {
+    mIsosurfaceSpans = std::make_unique<SpanSpace>(mMesh->connectivity(), scalar);
+  }
+
+  std::vector<vtkIdType> tets;
+  mIsosurfaceSpans->straddling(mIsovalue, tets);
+
+  mIsosurface = marching_tets(
+      mMesh->vertices(), mMesh->connectivity(), scalar,
+      {mIsovalue}, tets.data(), tets.size());
+  mIsosurfacePolyDataMapper->SetInputData(mIsosurface);
+  mIsosurfacePolyDataMapper->Update();
+}
+
 std::string VectorField::tail(std::string const& source, size_t const length) const {
   if (length >= source.size()) { return source; }
   return source.substr(source.size() - length);
@@ -29,13 +29,15 @@
 #define VECTOR_FIELD_H_
 
 #include <algorithm>
+#include <bitset>
+#include <cmath>
+#include <memory>
+#include <memory_resource>
 #include <string>
 #include <utility>
 #include <vector>
 
 #include <vtkActor.h>
-#include <vtkArrayCalculator.h>
-#include <vtkArrowSource.h>
 #include <vtkCellData.h>
 #include <vtkColorTransferFunction.h>
 #include <vtkCubeSource.h>
@@ -44,10 +46,7 @@
 #include <vtkDoubleArray.h>
 #include <vtkElevationFilter.h>
 #include <vtkFloatArray.h>
-#include <vtkGlyph3D.h>
-#include <vtkGradientFilter.h>
 #include <vtkLookupTable.h>
-#include <vtkMaskPoints.h>
 #include <vtkPointData.h>
 #include <vtkPolyDataMapper.h>
 #include <vtkProperty.h>
@@ -56,19 +55,94 @@
 #include <vtkRenderer.h>
 #include <vtkSmartPointer.h>
 #include <vtkSphereSource.h>
-#include <vtkTransform.h>
-#include <vtkTransformPolyDataFilter.h>
 #include <vtkUnstructuredGrid.h>
-#include <vtkContourGrid.h>
 
+#include "ArrowGlyphs.h"
+#include "CoreLines.h"
 #include "TecplotLoader.h"
+#include "TetMesh.h"
 #include "Utilities.h"
 #include "DebugMacros.h"
+#include "DemagEnergy.h"
+#include "Expression.h"
+#include "FieldStatistics.h"
+#include "GlyphSampling.h"
+#include "MarchingTets.h"
+#include "MemoryUsage.h"
+#include "MicromagneticEnergy.h"
+#include "PlaneSlicer.h"
+#include "SpanSpace.h"
+#include "TopologicalCharge.h"
 
+/**
+ * Integrated magnetic charges, in units of m times mesh area.
+ */
+struct MagneticCharges {
+  /// Net volume charge, -integral of div m.
+  double volume        = 0.0;
+  /// Net surface charge, integral of m.n (cancels the volume charge).
+  double surface       = 0.0;
+  /// Integral of |div m|.
+  double volumeAbs     = 0.0;
+  /// Integral of |m.n|.
+  double surfaceAbs    = 0.0;
+  /// The area of the boundary surface.
+  double area          = 0.0;
+};
+
+/**
+ * \brief A model (magnetisation on a shared tetrahedral mesh) and the
+ *        quantities and VTK pipelines derived from it.
+ *
+ * Only the grid and the magnetisation are built at load, every other product
+ * is computed on first request (through its accessor) and then memoised. The
+ * products form a small dependency graph, e.g. the volume averages need the
+ * helicity and the core lines need the volume averages, and requesting a
+ * product first computes whatever it depends on. Mesh products (geometric
+ * operators, boundary surface, ...) are lazy in the same way on TetMesh.
+ */
 class VectorField
 {
 public:
-  VectorField(std::string file, double arrowScale);
+  /// The number of cells along the longest side of the demag grid.
+  static const size_t DemagGridCells = 32;
+
+  /// The largest number of arrows drawn while the camera is moving.
+  static const size_t InteractiveGlyphs = 5000;
+
+  /**
+   * The derived products of a model.
+   */
+  enum Product {
+    /// Helicity array and the statistics of m and the helicity.
+    HELICITY,
+    /// Volume weighted means of m and the helicity.
+    VOLUME_AVERAGES,
+    /// Volume and surface charge arrays and totals.
+    CHARGES,
+    /// Topological charge density, patch charges and vortex cores.
+    TOPOLOGY,
+    /// The user defined expression array.
+    EXPRESSION,
+    /// Energy density arrays and totals, for the material parameters set.
+    ENERGIES,
+    /// The wireframe actor.
+    GEOMETRY,
+    /// The arrow glyphs.
+    ARROWS,
+    /// The vortex core lines.
+    CORE_LINES,
+    /// The isosurface.
+    ISOSURFACE,
+    /// The arrow glyphs on the slice plane.
+    SLICE,
+    NPRODUCTS
+  };
+
+  VectorField(
+      std::string                 file,
+      double                      arrowScale,
+      std::pmr::memory_resource * resource = std::pmr::get_default_resource());
 
   std::vector<std::string> split(const std::string &s, char delim);
 
@@ -78,21 +152,55 @@ public:
 
   std::string nameIndex() const;
   
-  double hmin() const { return mHmin; }
+  /// Whether a product has been computed yet.
+  bool computed(Product product) const { return mComputed[product]; }
+
+  double hmin() { require(HELICITY); return mHmin; }
+
+  double hmax() { require(HELICITY); return mHmax; }
+
+  double hmid() { require(HELICITY); return (mHmin+mHmax)/2.0; }
+
+  double mx() { require(HELICITY); return mMx; }
+
+  double my() { require(HELICITY); return mMy; }
 
-  double hmax() const { return mHmax; }
+  double mz() { require(HELICITY); return mMz; }
 
-  double hmid() const { return (mHmin+mHmax)/2.0; }
+  double mmag() { require(HELICITY); return mMmag; }
 
-  double mx() const { return mMx; }
+  /// The mean of the magnetisation magnitude (cf. mmag(), |mean m|).
+  double mmeanMagnitude() { require(HELICITY); return mStatistics.meanMagnitude(); }
 
-  double my() const { return mMy; }
+  double hmean() { require(HELICITY); return mStatistics.hmean(); }
 
-  double mz() const { return mMz; }
+  /**
+   * \brief The volume weighted mean magnetisation (integrated with lumped
+   *        nodal volumes), cf. the vertex averages mx(), my(), mz() which
+   *        over-weight densely meshed regions.
+   */
+  Vector3d mvolumeMean() { require(VOLUME_AVERAGES); return mVolumeMean; }
 
-  double mmag() const { return mMmag; }
+  /// The volume weighted mean helicity, cf. hmean().
+  double hvolumeMean() { require(VOLUME_AVERAGES); return mHvolumeMean; }
 
-  std::string handedness() const {
+  /**
+   * \brief The volume weighted average of a scalar point data array.
+   *
+   * \return the average, or NaN if there is no such (scalar) array.
+   */
+  double volumeAverage(const std::string & arrayName);
+
+  /// The (approximate, within 1%) q-quantile of the helicity.
+  double hquantile(double q) { require(HELICITY); return mStatistics.helicityQuantile(q); }
+
+  /**
+   * \brief Statistics of the magnetisation and helicity, accumulated in one
+   *        parallel pass along with the helicity.
+   */
+  const FieldStatistics & statistics() { require(HELICITY); return mStatistics; }
+
+  std::string handedness() {
     double hm = hmid();
     if (hm < 0.0) {
       return "Left";
@@ -101,71 +209,293 @@ public:
     }
   }
 
+  /**
+   * \brief Colour the arrows by helicity with the given colour map, this is
+   *        applied when the arrows are built if they have not been yet.
+   */
   void setArrowLut(vtkSmartPointer<vtkLookupTable> arrowLut)
   {
-    mArrowGlyphPolyDataMapper->SetLookupTable(arrowLut);
-    mArrowGlyphPolyDataMapper->SetScalarRange(mHmin, mHmax);
-    mArrowGlyphPolyDataMapper->Update();
-  }
-
-  vtkSmartPointer<vtkActor> arrows()     { return mArrowActor; }
-  vtkSmartPointer<vtkActor> geometry()   { return mGeometryActor; }
-  vtkSmartPointer<vtkActor> isosurface() { DEBUG("Returning isosurface"); return mIsosurfaceActor; }
-
-  void setArrowScale(double arrowScale) { 
-    if (fabs(mArrowScale - arrowScale) > 1E-9) {
-      mArrowScale = arrowScale; 
-      mArrowGlyph->SetScaleFactor(mArrowScale);
-      mArrowGlyph->Update();
+    mArrowLut = arrowLut;
+    mColourBy = "Helicity";
+    if (mComputed[ARROWS]) {
+      applyColourBy();
+    }
+    if (mComputed[SLICE]) {
+      colourSlice();
     }
   }
 
-  void setIsosurfaceHelicity(double helicity);
-
-  double isoSurfaceHelicity() { return mIsosurfaceHelicity; }
+  /// The arrow glyphs, re-glyphed first if the arrow scale has changed.
+  vtkSmartPointer<vtkActor> arrows();
+  vtkSmartPointer<vtkActor> geometry()   { require(GEOMETRY); return mGeometryActor; }
+  /// The helicity isosurface, this is contoured on first request.
+  vtkSmartPointer<vtkActor> isosurface() { require(ISOSURFACE); return mIsosurfaceActor; }
+  vtkSmartPointer<vtkActor> coreLines()  { require(CORE_LINES); return mCoreLinesActor; }
+  /// The arrow glyphs on the slice plane, re-sliced first if it has moved.
+  vtkSmartPointer<vtkActor> sliceArrows();
+
+  /**
+   * \brief Set the arrow scale, this is only recorded here and applied (one
+   *        glyph update) the next time the arrows are requested.
+   */
+  void setArrowScale(double arrowScale) { mArrowScale = arrowScale; }
+
+  /**
+   * \brief Draw about target arrows (every vertex if zero) at a spatially
+   *        uniform subset of vertices, shared by every model on the mesh,
+   *        or if adaptive at a subset of this model that is denser where
+   *        |grad m| is large. Applied the next time the arrows are
+   *        requested.
+   */
+  void setGlyphTarget(size_t target, bool adaptive);
+
+  /**
+   * \brief Draw the arrows with fewer, low-poly glyphs (while the camera is
+   *        being moved) or at full detail. Both sets are built together so
+   *        switching never re-glyphs.
+   */
+  void setInteractive(bool interactive);
+
+  /**
+   * \brief Only draw arrows at (and the wireframe of) the boundary surface,
+   *        which is extracted once per mesh. Applied to the arrows the next
+   *        time they are requested.
+   */
+  void setSurfaceOnly(bool surfaceOnly);
+
+  /**
+   * \brief Set the plane on which slice arrows are drawn (initially the
+   *        z = 0 plane), applied the next time they are requested. Arrows
+   *        are drawn where the plane cuts mesh edges, with m interpolated
+   *        along the edge.
+   */
+  void setSlicePlane(const Vertex3d & origin, const Vector3d & normal);
+
+  /**
+   * \brief Set the isovalue (of helicity, unless another array is contoured)
+   *        of the isosurface. If the isosurface has been built it is
+   *        re-contoured, visiting only the tetrahedra that straddle the new
+   *        value (found from a span space index that is built on the first
+   *        re-contour).
+   */
+  void setIsovalue(double value);
+
+  /**
+   * \brief Contour a different scalar point array at the given isovalue.
+   */
+  void setIsosurfaceArray(const std::string & arrayName, double value);
+
+  std::string isosurfaceArray() const { return mIsosurfaceArray; }
+
+  /**
+   * \brief Set a user defined scalar expression (vector expressions are
+   *        rejected), it is evaluated in to the point array Expression on
+   *        first request. An isosurface of Expression is not re-contoured,
+   *        the old isovalue is meaningless for the new array, so the caller
+   *        should set a new one with setIsosurfaceArray().
+   */
+  void setExpression(std::shared_ptr<const Expression> expression);
+
+  /**
+   * \brief Set the material parameters, the micromagnetic energy densities
+   *        (point arrays ExchangeEnergyDensity, AnisotropyEnergyDensity,
+   *        ZeemanEnergyDensity and EnergyDensity) and totals, including an
+   *        FFT estimate of the demagnetising energy on a resampled grid, are
+   *        computed on first request. An isosurface of an energy density is
+   *        not re-contoured, as for setExpression().
+   */
+  void setMaterialParameters(std::shared_ptr<const MaterialParameters> params);
+
+  /**
+   * \brief Integrated magnetic charges, the volume (-div m) and surface (m.n)
+   *        charge densities are the point arrays VolumeCharge and
+   *        SurfaceCharge (zero away from the boundary).
+   */
+  const MagneticCharges & charges() { require(CHARGES); return mCharges; }
+
+  /**
+   * \brief The topological charge (winding number of m) over the whole
+   *        boundary surface, the density is the point array
+   *        TopologicalChargeDensity (per unit area).
+   */
+  double topologicalCharge() { require(TOPOLOGY); return mTopologicalCharge; }
+
+  /// The topological charge of each boundary surface patch.
+  const std::vector<double> & patchCharges() { require(TOPOLOGY); return mPatchCharges; }
+
+  /// The points at which vortex cores pierce the boundary surface.
+  const std::vector<VortexCore> & vortexCores() { require(TOPOLOGY); return mVortexCores; }
+
+  /// The energy totals for the last material parameters set (zero if none).
+  const EnergyTotals & energies() { require(ENERGIES); return mEnergies; }
+
+  /**
+   * \brief Colour the arrows by a scalar point array, over the range of the
+   *        array in this model. Applied when the arrows are built if they
+   *        have not been yet.
+   */
+  void setColourBy(const std::string & arrayName, vtkSmartPointer<vtkLookupTable> lut);
+
+  /**
+   * \brief The range of a scalar point array, derived arrays are computed
+   *        if they have not been yet.
+   *
+   * \return false if there is no such array.
+   */
+  bool scalarRange(const std::string & arrayName, double range[2]);
+
+  /**
+   * \brief Interpolate the magnetisation at arbitrary points.
+   *
+   * Points are located in the (shared) mesh and the magnetisation is
+   * interpolated linearly using barycentric coordinates, points that are
+   * outside the mesh are given NaN components.
+   *
+   * \param[in]  points the points at which to probe the magnetisation.
+   * \param[out] m      the magnetisation at each point.
+   *
+   * \return the number of points that were inside the mesh.
+   */
+  size_t probe(const VertexField3d & points, VectorField3d & m) const;
+
+  /**
+   * \brief Resample the magnetisation on to a uniform grid, nodes outside the
+   *        mesh are zero. Interpolation weights are cached on the mesh, so
+   *        resampling further models on the same mesh is a sparse mat-vec.
+   */
+  void resample(const UniformGrid & grid, VectorField3d & m) const;
+
+  std::shared_ptr<TetMesh> mesh() const { return mMesh; }
+
+  /**
+   * \brief A breakdown of the memory held by this model. The mesh entry is
+   *        the (shared) mesh, so callers summing over models that share a
+   *        mesh should count it only once (see VectorFieldSet).
+   */
+  MemoryUsage memoryUsage() const;
+
+  /// The total memory held by this model.
+  size_t memoryBytes() const { return memoryUsage().total(); }
+
+  double isovalue() {
+    return std::isnan(mIsovalue) ? hmid() : mIsovalue;
+  }
 
 private:
   std::string                                 mName;
+  std::bitset<NPRODUCTS>                      mComputed;
   double                                      mHmin;
   double                                      mHmax;
   double                                      mMx;
   double                                      mMy;
   double                                      mMz;
   double                                      mMmag;
+  FieldStatistics                             mStatistics;
+  Vector3d                                    mVolumeMean;
+  double                                      mHvolumeMean;
+  EnergyTotals                                mEnergies;
+  MagneticCharges                             mCharges;
+  double                                      mTopologicalCharge;
+  std::vector<double>                         mPatchCharges;
+  std::vector<VortexCore>                     mVortexCores;
+  std::shared_ptr<const Expression>           mExpression;
+  std::shared_ptr<const MaterialParameters>   mMaterialParameters;
 
   double                                      mArrowScale;
+  std::string                                 mColourBy;
+  vtkSmartPointer<vtkLookupTable>             mArrowLut;
+  size_t                                      mGlyphTarget;
+  bool                                        mGlyphAdaptive;
+  bool                                        mArrowsDirty;
+  bool                                        mSurfaceOnly;
+  std::shared_ptr<const std::vector<vtkIdType>> mGlyphSample;
+  size_t                                      mAdaptiveGlyphTarget;
+  bool                                        mAdaptiveGlyphSurfaceOnly;
+  std::vector<vtkIdType>                      mAdaptiveGlyphSample;
+  bool                                        mInteractive;
+  std::shared_ptr<const std::vector<vtkIdType>> mCoarseGlyphSample;
+
+  Vertex3d                                    mSliceOrigin;
+  Vector3d                                    mSliceNormal;
+  bool                                        mSliceDirty;
+  PlaneSlice                                  mSlice;
+  std::vector<double>                         mSliceVectors;
+  std::vector<double>                         mSliceScalar;
+  ArrowGlyphs                                 mSliceGlyphs;
+  vtkSmartPointer<vtkPolyDataMapper>          mSliceGlyphPolyDataMapper;
+  vtkSmartPointer<vtkActor>                   mSliceActor;
+
+  std::shared_ptr<TetMesh>                    mMesh;
 
   vtkSmartPointer<vtkUnstructuredGrid>        mUGrid;
+  vtkSmartPointer<vtkDoubleArray>             mMagnetisation;
 
   vtkSmartPointer<vtkDataSetMapper>           mGeometryDataMapper;
   vtkSmartPointer<vtkActor>                   mGeometryActor;
 
-  vtkSmartPointer<vtkArrowSource>             mArrowSource;
-  vtkSmartPointer<vtkTransform>               mArrowTransform;
-  vtkSmartPointer<vtkTransformPolyDataFilter> mArrowTransformFilter;
-  vtkSmartPointer<vtkGlyph3D>                 mArrowGlyph;
+  ArrowGlyphs                                 mArrowGlyphs;
   vtkSmartPointer<vtkPolyDataMapper>          mArrowGlyphPolyDataMapper;
+  ArrowGlyphs                                 mCoarseArrowGlyphs;
+  vtkSmartPointer<vtkPolyDataMapper>          mCoarseArrowGlyphPolyDataMapper;
   vtkSmartPointer<vtkActor>                   mArrowActor;
 
-  double                                      mIsosurfaceHelicity;
-  vtkSmartPointer<vtkContourGrid>             mIsosurface;
+  double                                      mIsovalue;
+  std::string                                 mIsosurfaceArray;
+  vtkSmartPointer<vtkPolyData>                mIsosurface;
   vtkSmartPointer<vtkPolyDataMapper>          mIsosurfacePolyDataMapper;
   vtkSmartPointer<vtkActor>                   mIsosurfaceActor;
+  std::unique_ptr<SpanSpace>                  mIsosurfaceSpans;
 
-  void setGrid(
-      const VertexField3d   & vert, 
-      const ConnectIndices4 & conn);
+  vtkSmartPointer<vtkPolyData>                mCoreLines;
+  vtkSmartPointer<vtkPolyDataMapper>          mCoreLinesPolyDataMapper;
+  vtkSmartPointer<vtkActor>                   mCoreLinesActor;
+
+  void require(Product product);
+
+  void requireArray(const std::string & arrayName);
+
+  void setGrid();
 
   void setMagnetisation(const VectorField3d & field);
 
   void setHelicity();
 
+  void setVolumeAverages();
+
+  void setCharges();
+
+  void setTopology();
+
+  void evaluateExpression();
+
+  void setEnergies();
+
+  vtkDoubleArray * scalarArray(const char * name);
+
   void setGeometry();
 
+  void setGeometryInput();
+
   void setArrows();
 
+  void glyphArrows();
+
+  const std::vector<vtkIdType> * glyphSample();
+
+  void applyColourBy();
+
+  void setSlice();
+
+  void glyphSlice();
+
+  void colourSlice();
+
   void setIsosurface();
 
+  void contourIsosurface();
+
+  void setCoreLines();
+
   std::string tail(std::string const& source, size_t const length) const;
 
 };
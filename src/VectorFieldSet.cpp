@@ -25,6 +25,9 @@
  * SOFTWARE.
  **/
 
+#include <cmath>
+#include <limits>
+
 //#include "DebugMacros.h"
 #include "VectorFieldSet.h"
 
@@ -53,15 +56,27 @@ VectorFieldSet::VectorFieldSet(
     std::vector<std::string>     modelPaths, 
     vtkSmartPointer<vtkRenderer> renderer,
     double                       arrowFieldScale) :
-  mRenderer(renderer), mNLut(1000), withGeometry(false), withIsosurface(false)
+  mRenderer(renderer), mNLut(1000), mColourBy("Helicity"),
+  mIsosurfaceArray("Helicity"), withGeometry(false),
+  withIsosurface(false),
+  withCoreLines(false),
+  withSurfaceOnly(false),
+  withSlice(false),
+  mIsovalue(std::numeric_limits<double>::quiet_NaN()),
+  mResetCamera(true),
+  mScheduler(std::make_shared<RenderScheduler>(renderer->GetRenderWindow()))
 {
   mHmin =  1E12;
   mHmax = -1E12;
   size_t i = 0;
+  MemoryArena arena;
   for (auto p : modelPaths) {
-    std::shared_ptr<VectorField> f = std::make_shared<VectorField>(p, arrowFieldScale);
+    std::shared_ptr<VectorField> f = std::make_shared<VectorField>(p, arrowFieldScale, &arena);
     mFields.insert({p, f});
 
+    // Loader temporaries are no longer needed, release them in one shot.
+    arena.release();
+
     mNameToIdx.insert({p, i});
     mIdxToName.push_back(p);
 
@@ -72,8 +87,15 @@ VectorFieldSet::VectorFieldSet(
   }
   std::sort(mIdxToName.begin(), mIdxToName.end());
 
+  mArenaHighWaterMark = arena.highWaterMark();
+  INFO("Load arena high-water mark: " << mArenaHighWaterMark << " bytes");
+
+  // Every model is contoured at the same helicity, the middle of the range
+  // over the set.
+  mIsovalue = (mHmin + mHmax)/2.0;
+
   // Build the colour LUT
-  buildLut();
+  buildLut(mHmin, mHmax);
 
   // For each arrow model, update the colour LUT to be this colour LUT.
   for (auto kv : mFields) {
@@ -87,18 +109,30 @@ VectorFieldSet::VectorFieldSet(
     QProgressDialog              & progress,
     size_t                         offset,
     double                         arrowFieldScale) :
-  mRenderer(renderer), mNLut(1000), withGeometry(false), withIsosurface(false)
+  mRenderer(renderer), mNLut(1000), mColourBy("Helicity"),
+  mIsosurfaceArray("Helicity"), withGeometry(false),
+  withIsosurface(false),
+  withCoreLines(false),
+  withSurfaceOnly(false),
+  withSlice(false),
+  mIsovalue(std::numeric_limits<double>::quiet_NaN()),
+  mResetCamera(true),
+  mScheduler(std::make_shared<RenderScheduler>(renderer->GetRenderWindow()))
 {
   mHmin =  1E12;
   mHmax = -1E12;
   size_t i = 0;
+  MemoryArena arena;
   for (auto p : modelPaths) {
 
     progress.setValue(i+offset);
     
-    std::shared_ptr<VectorField> f = std::make_shared<VectorField>(p, arrowFieldScale);
+    std::shared_ptr<VectorField> f = std::make_shared<VectorField>(p, arrowFieldScale, &arena);
     mFields.insert({p, f});
 
+    // Loader temporaries are no longer needed, release them in one shot.
+    arena.release();
+
     progress.setValue(i+offset);
 
     mNameToIdx.insert({p, i});
@@ -112,8 +146,15 @@ VectorFieldSet::VectorFieldSet(
 
   std::sort(mIdxToName.begin(), mIdxToName.end());
 
+  mArenaHighWaterMark = arena.highWaterMark();
+  INFO("Load arena high-water mark: " << mArenaHighWaterMark << " bytes");
+
+  // Every model is contoured at the same helicity, the middle of the range
+  // over the set.
+  mIsovalue = (mHmin + mHmax)/2.0;
+
   // Build the colour LUT
-  buildLut();
+  buildLut(mHmin, mHmax);
 
   // For each arrow model, update the colour LUT to be this colour LUT.
   for (auto kv : mFields) {
@@ -129,33 +170,91 @@ std::string VectorFieldSet::currentDisplayName()
 }
 
 
-void VectorFieldSet::display(const std::string & name)
+void VectorFieldSet::display(const std::string & name, bool resetCamera)
+{
+  if (field(name) == NULL) {
+    return;
+  }
+
+  // The model is current straight away, but only the latest requested is
+  // built and drawn, once per display refresh.
+  mCurrentName = name;
+  mResetCamera = mResetCamera || resetCamera;
+  mScheduler->request([this]() { showCurrent(); });
+}
+
+void VectorFieldSet::showCurrent()
 {
-  auto actor    = field(name)->arrows();
-  auto gactor   = field(name)->geometry();
-  auto isoactor = field(name)->isosurface();
+  std::shared_ptr<VectorField> f = field(mCurrentName);
 
-  if (actor != NULL) {
-    mRenderer->RemoveAllViewProps();
+  std::vector< vtkSmartPointer<vtkProp> > props;
+  props.push_back(withSlice ? f->sliceArrows() : f->arrows());
 
-    mRenderer->AddActor(actor);
+  if (withGeometry) {
+    props.push_back(f->geometry());
+  }
 
-    if (withGeometry) {
-      if (gactor != NULL) {
-        mRenderer->AddActor(gactor);
-      }
-    }
+  if (withIsosurface) {
+    f->setIsovalue(mIsovalue);
+    props.push_back(f->isosurface());
+  }
+
+  if (withCoreLines) {
+    props.push_back(f->coreLines());
+  }
 
-    if (withIsosurface) {
-      if (isoactor != NULL) {
-        mRenderer->AddActor(isoactor);
-        //DEBUG("Added isosurface actor to renderer");
-      }
+  // The first model displayed clears the view (of any placeholder or the
+  // props of a previous set), after that only changed props are swapped.
+  if (mDisplayedProps.empty()) {
+    removeModelProps();
+  }
+  for (vtkSmartPointer<vtkProp> prop : mDisplayedProps) {
+    if (std::find(props.begin(), props.end(), prop) == props.end()) {
+      mRenderer->RemoveViewProp(prop);
     }
-      
+  }
+  for (vtkSmartPointer<vtkProp> prop : props) {
+    if (std::find(mDisplayedProps.begin(), mDisplayedProps.end(), prop)
+        == mDisplayedProps.end()) {
+      mRenderer->AddViewProp(prop);
+    }
+  }
+  mDisplayedProps = props;
+
+  if (mResetCamera) {
     mRenderer->ResetCamera();
-    mRenderer->GetRenderWindow()->Render();
-    mCurrentName = name;
+    mResetCamera = false;
+  }
+}
+
+void VectorFieldSet::setRenderedCallback(std::function<void()> callback)
+{
+  if (mScheduler) {
+    mScheduler->setRendered(callback);
+  }
+}
+
+void VectorFieldSet::requestRender()
+{
+  mScheduler->request();
+}
+
+void VectorFieldSet::removeModelProps()
+{
+  // NOTE: widget representations (e.g. the slice plane) are view props too,
+  //       but they belong to the view rather than to the model.
+  std::vector<vtkProp *> props;
+  vtkCollectionSimpleIterator it;
+  vtkPropCollection * viewProps = mRenderer->GetViewProps();
+  viewProps->InitTraversal(it);
+  while (vtkProp * prop = viewProps->GetNextProp(it)) {
+    if (vtkWidgetRepresentation::SafeDownCast(prop) == NULL) {
+      props.push_back(prop);
+    }
+  }
+
+  for (vtkProp * prop : props) {
+    mRenderer->RemoveViewProp(prop);
   }
 }
 
@@ -185,6 +284,134 @@ void VectorFieldSet::toggleIsosurface()
   display(mIdxToName[currentIdx]);
 }
 
+void VectorFieldSet::toggleCoreLines()
+{
+  size_t currentIdx = mNameToIdx[mCurrentName];
+
+  if (withCoreLines == false) {
+    withCoreLines = true;
+  } else {
+    withCoreLines = false;
+  }
+
+  display(mIdxToName[currentIdx]);
+}
+
+void VectorFieldSet::toggleSurfaceOnly()
+{
+  size_t currentIdx = mNameToIdx[mCurrentName];
+
+  if (withSurfaceOnly == false) {
+    withSurfaceOnly = true;
+  } else {
+    withSurfaceOnly = false;
+  }
+
+  // Cheap, models are only re-glyphed when they are next displayed.
+  for (auto kv : mFields) {
+    kv.second->setSurfaceOnly(withSurfaceOnly);
+  }
+
+  display(mIdxToName[currentIdx]);
+}
+
+void VectorFieldSet::toggleSlice()
+{
+  size_t currentIdx = mNameToIdx[mCurrentName];
+
+  if (withSlice == false) {
+    withSlice = true;
+  } else {
+    withSlice = false;
+  }
+
+  display(mIdxToName[currentIdx]);
+}
+
+void VectorFieldSet::setSlicePlane(const double origin[3], const double normal[3])
+{
+  Vertex3d o = {.x = origin[0], .y = origin[1], .z = origin[2]};
+  Vector3d n = {.x = normal[0], .y = normal[1], .z = normal[2]};
+
+  for (auto kv : mFields) {
+    kv.second->setSlicePlane(o, n);
+  }
+
+  // The displayed model is re-sliced when it is next drawn, so a drag is
+  // sliced at most once per display refresh.
+  if (withSlice && !mCurrentName.empty()) {
+    mScheduler->request([this]() { showCurrent(); });
+  }
+}
+
+void VectorFieldSet::setIsovalue(double value)
+{
+  mIsovalue = value;
+
+  if (withIsosurface && !mCurrentName.empty()) {
+    field(mCurrentName)->setIsovalue(value);
+    requestRender();
+  }
+}
+
+void VectorFieldSet::setIsosurfaceArray(const std::string & arrayName)
+{
+  double range[2] = {1E300, -1E300};
+  for (auto kv : mFields) {
+    double r[2];
+    if (!kv.second->scalarRange(arrayName, r)) {
+      ERROR("Cannot contour '" << arrayName << "'");
+      return;
+    }
+    range[0] = std::min(range[0], r[0]);
+    range[1] = std::max(range[1], r[1]);
+  }
+
+  // Every model is contoured at the middle of the range over the set.
+  mIsosurfaceArray = arrayName;
+  mIsovalue        = (range[0] + range[1])/2.0;
+  for (auto kv : mFields) {
+    kv.second->setIsosurfaceArray(arrayName, mIsovalue);
+  }
+
+  if (withIsosurface && !mCurrentName.empty()) {
+    requestRender();
+  }
+}
+
+void VectorFieldSet::isosurfaceRange(double range[2]) const
+{
+  range[0] =  1E300;
+  range[1] = -1E300;
+  for (auto kv : mFields) {
+    double r[2];
+    if (kv.second->scalarRange(kv.second->isosurfaceArray(), r)) {
+      range[0] = std::min(range[0], r[0]);
+      range[1] = std::max(range[1], r[1]);
+    }
+  }
+}
+
+void VectorFieldSet::setExpression(std::shared_ptr<const Expression> expression)
+{
+  for (auto kv : mFields) {
+    kv.second->setExpression(expression);
+  }
+
+  if (mColourBy == "Expression") {
+    setColourBy(mColourBy);
+  }
+
+  // The contoured array has a new range.
+  if (mIsosurfaceArray == "Expression") {
+    setIsosurfaceArray(mIsosurfaceArray);
+  }
+
+  if (!mCurrentName.empty()) {
+    requestRender();
+  }
+}
+
 void VectorFieldSet::nextModel()
 {
   size_t currentIdx = mNameToIdx[mCurrentName];
@@ -221,11 +448,77 @@ void VectorFieldSet::lastModel()
 
 void VectorFieldSet::setArrowScale(double arrowScale)
 {
+  // Only recorded in each model, the glyphs are rebuilt when displayed.
+  for (auto kv : mFields) {
+    kv.second->setArrowScale(arrowScale);
+  }
+
+  // The displayed model is re-glyphed straight away.
+  if (!mCurrentName.empty()) {
+    if (withSlice) {
+      field(mCurrentName)->sliceArrows();
+    } else {
+      field(mCurrentName)->arrows();
+    }
+  }
+}
+
+void VectorFieldSet::setGlyphTarget(size_t target, bool adaptive)
+{
+  for (auto kv : mFields) {
+    kv.second->setGlyphTarget(target, adaptive);
+  }
+
+  if (!mCurrentName.empty()) {
+    field(mCurrentName)->arrows();
+  }
+}
+
+void VectorFieldSet::setInteractive(bool interactive)
+{
+  if (!mCurrentName.empty()) {
+    field(mCurrentName)->setInteractive(interactive);
+  }
+}
+
+void VectorFieldSet::setMaterialParameters(const MaterialParameters & params)
+{
+  // Only recorded in each model, energies are computed on first request.
+  std::shared_ptr<const MaterialParameters> shared =
+      std::make_shared<const MaterialParameters>(params);
+  for (auto kv : mFields) {
+    kv.second->setMaterialParameters(shared);
+  }
+
+  // Energy arrays have changed, so may the colour map and the contoured
+  // range.
+  if (mColourBy.ends_with("EnergyDensity")) {
+    setColourBy(mColourBy);
+  }
+  if (mIsosurfaceArray.ends_with("EnergyDensity")) {
+    setIsosurfaceArray(mIsosurfaceArray);
+  }
+}
+
+void VectorFieldSet::setColourBy(const std::string & arrayName)
+{
+  double smin =  1E300;
+  double smax = -1E300;
   for (auto kv : mFields) {
-    auto key   = kv.first;
-    auto field = kv.second;
+    double range[2];
+    if (!kv.second->scalarRange(arrayName, range)) {
+      ERROR("Cannot colour by '" << arrayName << "'");
+      return;
+    }
+    smin = std::min(smin, range[0]);
+    smax = std::max(smax, range[1]);
+  }
 
-    field->setArrowScale(arrowScale);
+  mColourBy = arrayName;
+  buildLut(smin, smax);
+
+  for (auto kv : mFields) {
+    kv.second->setColourBy(arrayName, mLut);
   }
 }
 
@@ -239,6 +532,32 @@ std::shared_ptr<VectorField> & VectorFieldSet::operator[] (const std::string & n
   return mFields[name];
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// Function memoryUsage()                                                    //
+///////////////////////////////////////////////////////////////////////////////
+
+MemoryUsage VectorFieldSet::memoryUsage() const
+{
+  std::unordered_set<const TetMesh *> counted;
+  return memoryUsage(counted);
+}
+
+MemoryUsage VectorFieldSet::memoryUsage(
+    std::unordered_set<const TetMesh *> & counted) const
+{
+  MemoryUsage usage;
+
+  for (auto kv : mFields) {
+    MemoryUsage fieldUsage = kv.second->memoryUsage();
+    if (!counted.insert(kv.second->mesh().get()).second) {
+      fieldUsage.mesh = 0;
+    }
+    usage += fieldUsage;
+  }
+
+  return usage;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // Function field()                                                          //
 ///////////////////////////////////////////////////////////////////////////////
@@ -255,26 +574,26 @@ std::shared_ptr<VectorField> VectorFieldSet::field(const std::string & name)
 // Function buildLut()                                                       //
 ///////////////////////////////////////////////////////////////////////////////
 
-void VectorFieldSet::buildLut()
+void VectorFieldSet::buildLut(double smin, double smax)
 {
   mLut = vtkSmartPointer<vtkLookupTable>::New();
 
   vtkSmartPointer<vtkColorTransferFunction> ctf = 
     vtkSmartPointer<vtkColorTransferFunction>::New();
 
-  double ds = fabs(mHmax - mHmin)/(double)mNLut;
+  double ds = fabs(smax - smin)/(double)mNLut;
   
   mLut->SetNumberOfTableValues(mNLut);
 
   ctf->AddRGBSegment(
-      (mHmin)          , 0.0, 0.0, 1.0, 
-      (mHmin+mHmax)/2.0, 1.0, 1.0, 1.0);
+      (smin)         , 0.0, 0.0, 1.0, 
+      (smin+smax)/2.0, 1.0, 1.0, 1.0);
   ctf->AddRGBSegment(
-      (mHmin+mHmax)/2.0, 1.0, 1.0, 1.0,
-      (mHmax)          , 1.0, 0.0, 0.0);
+      (smin+smax)/2.0, 1.0, 1.0, 1.0,
+      (smax)         , 1.0, 0.0, 0.0);
 
   for (size_t i = 0; i < mNLut; ++i) {
-    double s    = mHmin+ ds*(double)i;
+    double s    = smin+ ds*(double)i;
 
     double *rgb = ctf->GetColor(s);
 
@@ -34,10 +34,9 @@
 #include <utility>
 #include <vector>
 #include <unordered_map>
+#include <unordered_set>
 
 #include <vtkActor.h>
-#include <vtkArrayCalculator.h>
-#include <vtkArrowSource.h>
 #include <vtkCellData.h>
 #include <vtkColorTransferFunction.h>
 #include <vtkCubeSource.h>
@@ -46,24 +45,24 @@
 #include <vtkDoubleArray.h>
 #include <vtkElevationFilter.h>
 #include <vtkFloatArray.h>
-#include <vtkGlyph3D.h>
-#include <vtkGradientFilter.h>
 #include <vtkLookupTable.h>
-#include <vtkMaskPoints.h>
 #include <vtkPointData.h>
 #include <vtkPolyDataMapper.h>
+#include <vtkPropCollection.h>
 #include <vtkProperty.h>
 #include <vtkQtTableView.h>
 #include <vtkRenderWindow.h>
 #include <vtkRenderer.h>
 #include <vtkSmartPointer.h>
+#include <vtkWidgetRepresentation.h>
 #include <vtkSphereSource.h>
-#include <vtkTransform.h>
-#include <vtkTransformPolyDataFilter.h>
 #include <vtkUnstructuredGrid.h>
 
 #include <QProgressDialog>
 
+#include "MemoryArena.h"
+#include "MemoryUsage.h"
+#include "RenderScheduler.h"
 #include "VectorField.h"
 
 std::vector<std::string> split(const std::string &s, char delim);
@@ -83,16 +82,83 @@ public:
       size_t                         offset,
       double                         arrowFieldScale);
 
-  VectorFieldSet() {}
+  VectorFieldSet() : mArenaHighWaterMark(0), mResetCamera(true) {}
 
   std::string currentDisplayName();
 
-  void display(const std::string & name);
+  /**
+   * \brief Make a model current and request that it is drawn. Requests are
+   *        coalesced (see RenderScheduler) so that holding a navigation key
+   *        builds and draws only the latest model, once per display
+   *        refresh. Props are swapped in the view and the camera is kept,
+   *        unless resetCamera (or this is the first model displayed).
+   */
+  void display(const std::string & name, bool resetCamera = false);
+
+  /**
+   * \brief Set a callback run after each (coalesced) render of the set, see
+   *        RenderScheduler::setRendered().
+   */
+  void setRenderedCallback(std::function<void()> callback);
 
   void toggleGeometry();
 
   void toggleIsosurface();
 
+  void toggleCoreLines();
+
+  /**
+   * \brief Toggle drawing only the boundary surface (arrows at surface
+   *        vertices and the surface wireframe) of every model.
+   */
+  void toggleSurfaceOnly();
+
+  /**
+   * \brief Toggle drawing arrows only on the slice plane, in place of the
+   *        arrows at mesh vertices.
+   */
+  void toggleSlice();
+
+  /**
+   * \brief Set the slice plane of every model, the displayed model is
+   *        re-sliced when it is next drawn (at most once per display
+   *        refresh), others are when they are displayed.
+   */
+  void setSlicePlane(const double origin[3], const double normal[3]);
+
+  /**
+   * \brief Set the isovalue of the isosurfaces, only the displayed model is
+   *        re-contoured straight away, others are when they are displayed.
+   */
+  void setIsovalue(double value);
+
+  /**
+   * \brief Contour a different scalar point array in every model, at the
+   *        middle of its range over the set, see
+   *        VectorField::setIsosurfaceArray().
+   */
+  void setIsosurfaceArray(const std::string & arrayName);
+
+  std::string isosurfaceArray() const { return mIsosurfaceArray; }
+
+  /**
+   * \brief The range of the contoured array over the whole set.
+   */
+  void isosurfaceRange(double range[2]) const;
+
+  /**
+   * \brief Set a user defined expression in every model, each evaluates it
+   *        on first request, see VectorField::setExpression(). If it is
+   *        contoured the isovalue is reset to the middle of its new range.
+   */
+  void setExpression(std::shared_ptr<const Expression> expression);
+
+  /// The smallest helicity over the set.
+  double hmin() const { return mHmin; }
+
+  /// The largest helicity over the set.
+  double hmax() const { return mHmax; }
+
   void nextModel();
 
   void previousModel();
@@ -101,8 +167,41 @@ public:
 
   void lastModel();
 
+  /**
+   * \brief Set the arrow scale of every model, only the displayed model is
+   *        re-glyphed straight away, others are when they are displayed.
+   */
   void setArrowScale(double arrowScale);
 
+  /**
+   * \brief Set the number of arrows drawn in every model, see
+   *        VectorField::setGlyphTarget(). Only the displayed model is
+   *        re-glyphed straight away.
+   */
+  void setGlyphTarget(size_t target, bool adaptive);
+
+  /**
+   * \brief Switch the displayed model to its interactive (coarse) arrows
+   *        while the camera is being moved, see VectorField::setInteractive().
+   */
+  void setInteractive(bool interactive);
+
+  /**
+   * \brief Set the material parameters of every model, each computes its
+   *        energies on first request, see
+   *        VectorField::setMaterialParameters(). If an energy density is
+   *        contoured the isovalue is reset to the middle of its new range.
+   */
+  void setMaterialParameters(const MaterialParameters & params);
+
+  /**
+   * \brief Colour the arrows of every model by a scalar point array, the
+   *        colour map spans the range of the array over the whole set.
+   */
+  void setColourBy(const std::string & arrayName);
+
+  std::string colourBy() const { return mColourBy; }
+
   inline size_t size() const { return mFields.size(); }
 
   std::shared_ptr<VectorField> & operator[] (size_t idx);
@@ -111,6 +210,20 @@ public:
 
   std::string currentName() const { return mCurrentName; }
 
+  size_t arenaHighWaterMark() const { return mArenaHighWaterMark; }
+
+  /**
+   * \brief The memory held by all models in the set, meshes shared between
+   *        models are counted once.
+   */
+  MemoryUsage memoryUsage() const;
+
+  /**
+   * \brief As memoryUsage() but skipping meshes already in 'counted' (which
+   *        is updated), so that meshes shared between sets count once.
+   */
+  MemoryUsage memoryUsage(std::unordered_set<const TetMesh *> & counted) const;
+
 private:
   vtkSmartPointer<vtkRenderer>                                    mRenderer;
   std::unordered_map< std::string, std::shared_ptr<VectorField> > mFields;
@@ -121,11 +234,26 @@ private:
   double                                                          mHmax;
   size_t                                                          mNLut;
   vtkSmartPointer<vtkLookupTable>                                 mLut;
+  std::string                                                     mColourBy;
+  std::string                                                     mIsosurfaceArray;
   bool withGeometry;
   bool withIsosurface;
+  bool withCoreLines;
+  bool withSurfaceOnly;
+  bool withSlice;
+  /// The isovalue of every model, initially the middle helicity of the set.
+  double                                                          mIsovalue;
+  size_t                                                          mArenaHighWaterMark;
+  bool                                                            mResetCamera;
+  /// The props of the current model in the view.
+  std::vector< vtkSmartPointer<vtkProp> >                         mDisplayedProps;
+  std::shared_ptr<RenderScheduler>                                mScheduler;
 
   std::shared_ptr<VectorField> field(const std::string & name);
-  void buildLut();
+  void removeModelProps();
+  void showCurrent();
+  void requestRender();
+  void buildLut(double smin, double smax);
 };
 
 #endif  // VECTOR_FIELD_SET_H_